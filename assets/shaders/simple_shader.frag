@@ -1,11 +1,22 @@
 #version 450
+#extension GL_EXT_nonuniform_qualifier : require
 
-layout(binding = 1) uniform sampler2D texSampler;
+// the bindless texture table, indexed by texture handle; sized when the set is allocated
+layout(binding = 2) uniform sampler2D textures[];
+
+// set for the opaque pipeline, which writes depth and doesn't blend;
+// translucent texels are cut out instead, so they hide nothing behind them
+layout(constant_id = 0) const bool ALPHA_TEST = false;
 
 layout(location = 0) in vec2 fragTexCoord;
+layout(location = 1) flat in uint fragTexture;
 
 layout(location = 0) out vec4 outColor;
 
 void main() {
-    outColor = texture(texSampler, fragTexCoord);
-}
+    // instances in one draw may select different textures
+    outColor = texture(textures[nonuniformEXT(fragTexture)], fragTexCoord);
+    if (ALPHA_TEST && outColor.a < 0.5) {
+        discard;
+    }
+}
\ No newline at end of file
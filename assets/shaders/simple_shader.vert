@@ -1,13 +1,14 @@
 #version 450
 
-// vertex attrs
-layout(location = 0) in vec2 xy;
+// vertex attrs; a fan slot of the whole quad, used when the region has no mesh
+layout(location = 0) in vec2 quadXy;
 
-// instanced attrs
-layout(location = 1) in vec3 pos;
-layout(location = 2) in vec3 rot;
-layout(location = 3) in vec3 scale;
+// instanced attrs; rows 0-2 of the model matrix, precomputed on the CPU
+layout(location = 1) in vec4 model0;
+layout(location = 2) in vec4 model1;
+layout(location = 3) in vec4 model2;
 layout(location = 4) in uint texId;
+layout(location = 5) in uint texture;
 
 layout(binding = 0) uniform UBO1 {
     mat4 proj;
@@ -16,113 +17,31 @@ layout(binding = 0) uniform UBO1 {
     vec2 user2;
 } ubo1;
 
-layout(location = 0) out vec2 fragTexCoord;
-
-// generate model matrix from position, rotation, and scale
-mat4 generateModelMatrix(vec3 position, vec3 rotation, vec3 scale) {
-    // Rotation matrices for each axis
-    mat4 rotX = mat4(
-        1.0, 0.0, 0.0, 0.0,
-        0.0, cos(rotation.x), -sin(rotation.x), 0.0,
-        0.0, sin(rotation.x), cos(rotation.x), 0.0,
-        0.0, 0.0, 0.0, 1.0
-    );
-    mat4 rotY = mat4(
-        cos(rotation.y), 0.0, sin(rotation.y), 0.0,
-        0.0, 1.0, 0.0, 0.0,
-        -sin(rotation.y), 0.0, cos(rotation.y), 0.0,
-        0.0, 0.0, 0.0, 1.0
-    );
-    mat4 rotZ = mat4(
-        cos(rotation.z), -sin(rotation.z), 0.0, 0.0,
-        sin(rotation.z), cos(rotation.z), 0.0, 0.0,
-        0.0, 0.0, 1.0, 0.0,
-        0.0, 0.0, 0.0, 1.0
-    );
-
-    // Combine rotation matrices
-    mat4 rotationMatrix = rotX * rotY * rotZ;
-
-    // Scale matrix
-    mat4 scaleMatrix = mat4(
-        scale.x, 0.0, 0.0, 0.0,
-        0.0, scale.y, 0.0, 0.0,
-        0.0, 0.0, scale.z, 0.0,
-        0.0, 0.0, 0.0, 1.0
-    );
-
-    // Translation matrix
-    mat4 translationMatrix = mat4(
-        1.0, 0.0, 0.0, 0.0,
-        0.0, 1.0, 0.0, 0.0,
-        0.0, 0.0, 1.0, 0.0,
-        position.x, position.y, position.z, 1.0
-    );
-
-    // Combine translation, rotation, and scale
-    mat4 modelMatrix = translationMatrix * rotationMatrix * scaleMatrix;
-
-    return modelMatrix;
-}
-
-uint ATLAS_W = 2632;
-uint ATLAS_H = 1721;
+// sprite regions in the texture atlas, indexed by texId; matches AtlasRegion_t
+struct AtlasRegion {
+    vec4 uvwh;
+    vec2 mesh[8];  // fan slots, in the quad's space; trims the region's transparent border
+    uint meshCount;
+};
 
-vec2 TEXTURE_WH = vec2(ATLAS_W,ATLAS_H);
-float pixelsToUnitsX(uint pixels) {
-    return pixels / TEXTURE_WH.x;
-}
-float pixelsToUnitsY(uint pixels) {
-    return pixels / TEXTURE_WH.y;
-}
+layout(std430, binding = 1) readonly buffer Atlas {
+    AtlasRegion regions[];
+};
 
-uint SPRITE_X = 0;
-uint SPRITE_Y = 690;
-uint SPRITE_W = 300;
-uint SPRITE_H = 450;
-uint SPRITE_IDX_OFFSET = 3;
-uint SPRITE_ROW_LEN = 8;
-uint WOOD_WALL_W = 350;
-uint WOOD_WALL_H = 420;
+layout(location = 0) out vec2 fragTexCoord;
+layout(location = 1) flat out uint fragTexture;
 
 void main() {
-    mat4 model = generateModelMatrix(pos, rot, scale);
-    gl_Position = ubo1.proj * ubo1.view * model * vec4(-xy.x, xy.y, 0.0, 1.0);
-
-    // hard-coded map of texId to uvwh coords in texture atlas
-    vec4 uvwh;
-    if (0 == texId) { // background 0x0 1574x684
-        uvwh = vec4(pixelsToUnitsX(0),pixelsToUnitsY(0),pixelsToUnitsX(1574),pixelsToUnitsY(684));
-    }
-    else if (1 == texId) { // wood-wall 1 1580x0 350x420
-        uvwh = vec4(pixelsToUnitsX(1580),pixelsToUnitsY(0),pixelsToUnitsX(WOOD_WALL_W),pixelsToUnitsY(WOOD_WALL_H));
-    }
-    else if (2 == texId) { // wood-wall 1 1580x0 350x420
-        uvwh = vec4(pixelsToUnitsX(1580 + WOOD_WALL_W),pixelsToUnitsY(0),pixelsToUnitsX(WOOD_WALL_W),pixelsToUnitsY(WOOD_WALL_H));
-    }
-
-    // sprites
-    else if (texId >= SPRITE_IDX_OFFSET) {
-        uint x = (texId - SPRITE_IDX_OFFSET);
-        uint y = (x / SPRITE_ROW_LEN);
-        x = x % SPRITE_ROW_LEN;
-        uvwh = vec4(
-            pixelsToUnitsX(SPRITE_X + (SPRITE_W * x)),
-            pixelsToUnitsY(SPRITE_Y + (SPRITE_H * y)),
-            pixelsToUnitsX(SPRITE_W),
-            pixelsToUnitsY(SPRITE_H));
-    }
-
-    if (xy.x == 0.5 && xy.y == -0.5) {
-        fragTexCoord = vec2(uvwh.x, uvwh.y); // top-left
-    }
-    else if (xy.x == -0.5 && xy.y == -0.5) {
-        fragTexCoord = vec2(uvwh.x+uvwh.z, uvwh.y); // top-right
-    }
-    else if (xy.x == -0.5 && xy.y == 0.5) {
-        fragTexCoord = vec2(uvwh.x+uvwh.z, uvwh.y+uvwh.w); // bottom-right
-    }
-    else if (xy.x == 0.5 && xy.y == 0.5) {
-        fragTexCoord = vec2(uvwh.x, uvwh.y+uvwh.w); // bottom-left
-    }
+    // every region is drawn as the same fan; the index is the slot
+    // the CPU checks texId as instances change; clamped anyway, as a bad id reads past the buffer
+    AtlasRegion region = regions[min(texId, uint(regions.length()) - 1)];
+    vec2 xy = region.meshCount > 0 ? region.mesh[gl_VertexIndex] : quadXy;
+
+    vec4 local = vec4(-xy.x, xy.y, 0.0, 1.0);
+    vec4 world = vec4(dot(model0, local), dot(model1, local), dot(model2, local), 1.0);
+    gl_Position = ubo1.proj * ubo1.view * world;
+
+    // corners are +/-0.5; x is mirrored, to match the flipped position above
+    fragTexCoord = region.uvwh.xy + region.uvwh.zw * vec2(0.5 - xy.x, xy.y + 0.5);
+    fragTexture = texture;
 }
\ No newline at end of file
@@ -194,6 +194,9 @@ const shaders = async () => {
 
   await child_spawn(GLSLC_PATH,
     ['../assets/shaders/simple_shader.frag', '-o', '../assets/shaders/simple_shader.frag.spv']);
+
+  await child_spawn(GLSLC_PATH,
+    ['../assets/shaders/cull.comp', '-o', '../assets/shaders/cull.comp.spv']);
 };
 
 const protobuf = async () => {
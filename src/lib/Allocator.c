@@ -0,0 +1,313 @@
+#include "Allocator.h"
+
+#include <stdlib.h>
+
+#include "Base.h"
+
+#define NODES_COUNT ((1u << ALLOCATOR_DEPTHS) - 1)
+#define NODE_NIL UINT32_MAX
+
+typedef enum {
+  NODE_UNUSED = 0,  // covered by an ancestor
+  NODE_FREE = 1,    // available; linked into the free list of its depth
+  NODE_SPLIT = 2,   // divided between its two children
+  NODE_USED = 3,    // handed out
+} NodeState_t;
+
+static VkDeviceSize RoundUpPow2(VkDeviceSize n) {
+  VkDeviceSize p = 1;
+  while (p < n) {
+    p <<= 1;
+  }
+  return p;
+}
+
+static u32 Log2(VkDeviceSize pow2) {
+  return (u32)__builtin_ctzll(pow2);
+}
+
+static u32 NodeDepth(u32 node) {
+  return 31 - __builtin_clz(node + 1);
+}
+
+static VkDeviceSize NodeOffset(u32 node) {
+  const u32 depth = NodeDepth(node);
+  return (VkDeviceSize)(node - ((1u << depth) - 1)) *
+         ((VkDeviceSize)ALLOCATOR_BLOCK_BYTES >> depth);
+}
+
+static void FreeListPush(AllocatorBlock_t* block, u32 depth, u32 node) {
+  block->m_state[node] = NODE_FREE;
+  block->m_prev[node] = NODE_NIL;
+  block->m_next[node] = block->m_freeHeads[depth];
+  if (NODE_NIL != block->m_freeHeads[depth]) {
+    block->m_prev[block->m_freeHeads[depth]] = node;
+  }
+  block->m_freeHeads[depth] = node;
+}
+
+static void FreeListRemove(AllocatorBlock_t* block, u32 depth, u32 node) {
+  if (NODE_NIL != block->m_prev[node]) {
+    block->m_next[block->m_prev[node]] = block->m_next[node];
+  } else {
+    block->m_freeHeads[depth] = block->m_next[node];
+  }
+  if (NODE_NIL != block->m_next[node]) {
+    block->m_prev[block->m_next[node]] = block->m_prev[node];
+  }
+}
+
+static bool BlockAlloc(AllocatorBlock_t* block, u32 depth, u32* node) {
+  // find the deepest level at or above the request which has a free node
+  s32 d = depth;
+  while (d >= 0 && NODE_NIL == block->m_freeHeads[d]) {
+    d--;
+  }
+  if (d < 0) {
+    return false;
+  }
+
+  u32 n = block->m_freeHeads[d];
+  FreeListRemove(block, d, n);
+
+  // split down to the requested size, keeping the right halves free
+  for (; (u32)d < depth; d++) {
+    block->m_state[n] = NODE_SPLIT;
+    FreeListPush(block, d + 1, 2 * n + 2);
+    n = 2 * n + 1;
+  }
+
+  block->m_state[n] = NODE_USED;
+  *node = n;
+  return true;
+}
+
+static void BlockFree(AllocatorBlock_t* block, u32 node) {
+  u32 depth = NodeDepth(node);
+  block->m_state[node] = NODE_UNUSED;
+
+  // merge with free buddies, as far up as possible
+  while (0 != node) {
+    const u32 buddy = (node & 1) ? node + 1 : node - 1;
+    if (NODE_FREE != block->m_state[buddy]) {
+      break;
+    }
+    FreeListRemove(block, depth, buddy);
+    block->m_state[buddy] = NODE_UNUSED;
+    node = (node - 1) / 2;
+    depth--;
+  }
+
+  FreeListPush(block, depth, node);
+}
+
+static void AllocateDeviceMemory(
+    Allocator_t* self, u32 memoryType, VkDeviceSize size, VkDeviceMemory* memory, void** mapped) {
+  ASSERT_CONTEXT(
+      self->m_deviceAllocations < self->m_maxDeviceAllocations,
+      "Exceeded maxMemoryAllocationCount. count: %u",
+      self->m_deviceAllocations)
+
+  VkMemoryAllocateInfo allocInfo;
+  allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+  allocInfo.pNext = NULL;
+  allocInfo.allocationSize = size;
+  allocInfo.memoryTypeIndex = memoryType;
+
+  ASSERT_CONTEXT(
+      VK_SUCCESS == vkAllocateMemory(self->m_device, &allocInfo, NULL, memory),
+      "vkAllocateMemory failed. memoryType: %u, size: %llu",
+      memoryType,
+      (unsigned long long)size)
+  self->m_deviceAllocations++;
+
+  *mapped = NULL;
+  if (self->m_memoryProperties.memoryTypes[memoryType].propertyFlags &
+      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+    ASSERT(VK_SUCCESS == vkMapMemory(self->m_device, *memory, 0, VK_WHOLE_SIZE, 0, mapped))
+  }
+}
+
+void Allocator__New(Allocator_t* self, VkPhysicalDevice physicalDevice, VkDevice device) {
+  self->m_device = device;
+  self->m_deviceAllocations = 0;
+  self->m_blocksCount = 0;
+
+  // cached; memory properties don't change for the lifetime of the device
+  vkGetPhysicalDeviceMemoryProperties(physicalDevice, &self->m_memoryProperties);
+
+  VkPhysicalDeviceProperties properties;
+  vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+  self->m_maxDeviceAllocations = properties.limits.maxMemoryAllocationCount;
+
+  for (u32 i = 0; i < VK_MAX_MEMORY_HEAPS; i++) {
+    self->m_heapReserved[i] = 0;
+    self->m_heapUsed[i] = 0;
+    self->m_heapAllocationsCount[i] = 0;
+  }
+}
+
+u32 Allocator__FindMemoryType(Allocator_t* self, u32 typeFilter, VkMemoryPropertyFlags properties) {
+  for (u32 i = 0; i < self->m_memoryProperties.memoryTypeCount; i++) {
+    if ((typeFilter & (1 << i)) &&
+        (self->m_memoryProperties.memoryTypes[i].propertyFlags & properties) == properties) {
+      return i;
+    }
+  }
+
+  ASSERT_CONTEXT(false, "failed to find suitable memory type!");
+  return 0;
+}
+
+void Allocator__Alloc(
+    Allocator_t* self,
+    const VkMemoryRequirements* requirements,
+    VkMemoryPropertyFlags properties,
+    bool linear,
+    Allocation_t* allocation) {
+  const u32 memoryType =
+      Allocator__FindMemoryType(self, requirements->memoryTypeBits, properties);
+  const u32 heap = self->m_memoryProperties.memoryTypes[memoryType].heapIndex;
+  allocation->memoryType = memoryType;
+
+  // buddy nodes are naturally aligned to their own size
+  const VkDeviceSize size = RoundUpPow2(
+      MATH_MAX(MATH_MAX(requirements->size, requirements->alignment), ALLOCATOR_MIN_BYTES));
+
+  if (size > ALLOCATOR_BLOCK_BYTES / 2) {
+    AllocateDeviceMemory(
+        self,
+        memoryType,
+        requirements->size,
+        &allocation->memory,
+        &allocation->mapped);
+    allocation->offset = 0;
+    allocation->size = requirements->size;
+    allocation->block = ALLOCATOR_DEDICATED;
+    allocation->node = 0;
+
+    self->m_heapReserved[heap] += allocation->size;
+    self->m_heapUsed[heap] += allocation->size;
+    self->m_heapAllocationsCount[heap]++;
+    return;
+  }
+
+  const u32 depth = Log2(ALLOCATOR_BLOCK_BYTES) - Log2(size);
+  u32 node;
+  AllocatorBlock_t* block = NULL;
+  for (u32 i = 0; i < self->m_blocksCount; i++) {
+    if (self->m_blocks[i].m_memoryType == memoryType && self->m_blocks[i].m_linear == linear &&
+        BlockAlloc(&self->m_blocks[i], depth, &node)) {
+      block = &self->m_blocks[i];
+      allocation->block = i;
+      break;
+    }
+  }
+
+  if (NULL == block) {
+    ASSERT_CONTEXT(
+        self->m_blocksCount < ALLOCATOR_BLOCKS_CAP,
+        "Out of allocator blocks. Raise ALLOCATOR_BLOCKS_CAP. count: %u",
+        self->m_blocksCount)
+    allocation->block = self->m_blocksCount;
+    block = &self->m_blocks[self->m_blocksCount++];
+    block->m_memoryType = memoryType;
+    block->m_linear = linear;
+    block->m_used = 0;
+    block->m_allocationsCount = 0;
+    AllocateDeviceMemory(
+        self,
+        memoryType,
+        ALLOCATOR_BLOCK_BYTES,
+        &block->m_memory,
+        &block->m_mapped);
+
+    block->m_state = calloc(NODES_COUNT, sizeof(u8));
+    block->m_next = malloc(NODES_COUNT * sizeof(u32));
+    block->m_prev = malloc(NODES_COUNT * sizeof(u32));
+    ASSERT(block->m_state && block->m_next && block->m_prev)
+    for (u32 d = 0; d < ALLOCATOR_DEPTHS; d++) {
+      block->m_freeHeads[d] = NODE_NIL;
+    }
+    FreeListPush(block, 0, 0);
+
+    self->m_heapReserved[heap] += ALLOCATOR_BLOCK_BYTES;
+
+    LOG_DEBUGF(
+        "allocator reserved block %u. memoryType: %u, linear: %u",
+        allocation->block,
+        memoryType,
+        linear)
+
+    ASSERT(BlockAlloc(block, depth, &node))
+  }
+
+  block->m_used += size;
+  block->m_allocationsCount++;
+
+  allocation->memory = block->m_memory;
+  allocation->node = node;
+  allocation->offset = NodeOffset(node);
+  allocation->size = size;
+  allocation->mapped = NULL != block->m_mapped ? (u8*)block->m_mapped + allocation->offset : NULL;
+
+  self->m_heapUsed[heap] += size;
+  self->m_heapAllocationsCount[heap]++;
+}
+
+void Allocator__Free(Allocator_t* self, Allocation_t* allocation) {
+  if (VK_NULL_HANDLE == allocation->memory) {
+    return;
+  }
+
+  const u32 heap = self->m_memoryProperties.memoryTypes[allocation->memoryType].heapIndex;
+  self->m_heapUsed[heap] -= allocation->size;
+  self->m_heapAllocationsCount[heap]--;
+
+  if (ALLOCATOR_DEDICATED == allocation->block) {
+    // NOTICE: memory is implicitly unmapped when freed
+    vkFreeMemory(self->m_device, allocation->memory, NULL);
+    self->m_deviceAllocations--;
+    self->m_heapReserved[heap] -= allocation->size;
+  } else {
+    // blocks are retained once reserved, to avoid churn
+    AllocatorBlock_t* block = &self->m_blocks[allocation->block];
+    BlockFree(block, allocation->node);
+    block->m_used -= allocation->size;
+    block->m_allocationsCount--;
+  }
+
+  allocation->memory = VK_NULL_HANDLE;
+  allocation->mapped = NULL;
+}
+
+void Allocator__LogStats(Allocator_t* self) {
+  LOG_INFOF(
+      "device memory: vkAllocateMemory count %u / %u, blocks %u",
+      self->m_deviceAllocations,
+      self->m_maxDeviceAllocations,
+      self->m_blocksCount)
+  for (u32 i = 0; i < self->m_memoryProperties.memoryHeapCount; i++) {
+    LOG_INFOF(
+        "  heap %u:%s size %llu KB, reserved %llu KB, used %llu KB, allocations %u",
+        i,
+        (self->m_memoryProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)
+            ? " DEVICE_LOCAL"
+            : "",
+        (unsigned long long)(self->m_memoryProperties.memoryHeaps[i].size / 1024),
+        (unsigned long long)(self->m_heapReserved[i] / 1024),
+        (unsigned long long)(self->m_heapUsed[i] / 1024),
+        self->m_heapAllocationsCount[i])
+  }
+}
+
+void Allocator__Shutdown(Allocator_t* self) {
+  for (u32 i = 0; i < self->m_blocksCount; i++) {
+    vkFreeMemory(self->m_device, self->m_blocks[i].m_memory, NULL);
+    free(self->m_blocks[i].m_state);
+    free(self->m_blocks[i].m_next);
+    free(self->m_blocks[i].m_prev);
+  }
+  self->m_deviceAllocations -= self->m_blocksCount;
+  self->m_blocksCount = 0;
+}
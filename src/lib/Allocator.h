@@ -0,0 +1,74 @@
+#ifndef ALLOCATOR_H
+#define ALLOCATOR_H
+
+// A device memory allocator
+// it reserves large blocks per memory type with vkAllocateMemory,
+// and sub-allocates aligned ranges from them using buddy bookkeeping.
+// - allocations are rounded up to a power of two (min ALLOCATOR_MIN_BYTES)
+// - buffers and images never share a block, so bufferImageGranularity never applies
+// - host-visible blocks are mapped once, for their lifetime
+// - requests larger than half a block get a dedicated vkAllocateMemory
+
+#define VK_NO_PROTOTYPES
+#include <volk.h>
+
+#include "Base.h"
+
+#define ALLOCATOR_BLOCK_BYTES 64 * 1024 * 1024  // MB
+#define ALLOCATOR_MIN_BYTES 1024                // KB
+#define ALLOCATOR_DEPTHS 17                     // log2(BLOCK / MIN) + 1
+#define ALLOCATOR_BLOCKS_CAP 64
+#define ALLOCATOR_DEDICATED -1
+
+typedef struct {
+  VkDeviceMemory memory;
+  VkDeviceSize offset;
+  VkDeviceSize size;
+  void* mapped;  // NULL unless host-visible
+  s32 block;     // index into m_blocks, or ALLOCATOR_DEDICATED
+  u32 node;
+  u32 memoryType;
+} Allocation_t;
+
+typedef struct {
+  VkDeviceMemory m_memory;
+  u32 m_memoryType;
+  bool m_linear;
+  void* m_mapped;
+  // per node of the implicit binary tree; root is node 0, children of n are 2n+1 and 2n+2
+  u8* m_state;
+  // doubly-linked free list per depth, threaded through node indices
+  u32* m_next;
+  u32* m_prev;
+  u32 m_freeHeads[ALLOCATOR_DEPTHS];
+  VkDeviceSize m_used;
+  u32 m_allocationsCount;
+} AllocatorBlock_t;
+
+typedef struct {
+  VkDevice m_device;
+  VkPhysicalDeviceMemoryProperties m_memoryProperties;
+  u32 m_maxDeviceAllocations;
+  u32 m_deviceAllocations;
+  u32 m_blocksCount;
+  AllocatorBlock_t m_blocks[ALLOCATOR_BLOCKS_CAP];
+
+  // statistics, per heap
+  VkDeviceSize m_heapReserved[VK_MAX_MEMORY_HEAPS];
+  VkDeviceSize m_heapUsed[VK_MAX_MEMORY_HEAPS];
+  u32 m_heapAllocationsCount[VK_MAX_MEMORY_HEAPS];
+} Allocator_t;
+
+void Allocator__New(Allocator_t* self, VkPhysicalDevice physicalDevice, VkDevice device);
+u32 Allocator__FindMemoryType(Allocator_t* self, u32 typeFilter, VkMemoryPropertyFlags properties);
+void Allocator__Alloc(
+    Allocator_t* self,
+    const VkMemoryRequirements* requirements,
+    VkMemoryPropertyFlags properties,
+    bool linear,
+    Allocation_t* allocation);
+void Allocator__Free(Allocator_t* self, Allocation_t* allocation);
+void Allocator__LogStats(Allocator_t* self);
+void Allocator__Shutdown(Allocator_t* self);
+
+#endif
@@ -0,0 +1,361 @@
+#include "Atlas.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "File.h"
+
+#define MESH_INPUT_CAP (ATLAS_MESH_CAP * 2 + 2)  // numbers on a mesh line, and a spare to reject
+#define MESH_MAX_AREA 0.9f  // of the quad; meshes covering more save too little to be worth it
+
+void Atlas__Load(Atlas_t* self, const char* file) {
+  LOG_INFOF("reading atlas file: %s", file)
+
+  memset(self, 0, sizeof(Atlas_t));
+  self->m_regions = malloc(ATLAS_REGIONS_CAP * sizeof(AtlasRegion_t));
+  ASSERT(self->m_regions)
+
+  FILE* fh;
+  ASSERT(0 == fopen_s(&fh, file, "r"))
+  ASSERT(NULL != fh)
+
+  char line[256];
+  u32 lineNo = 0;
+  u32 regionW = 0;
+  u32 regionH = 0;
+  while (NULL != fgets(line, sizeof(line), fh)) {
+    lineNo++;
+    char* comment = strchr(line, '#');
+    if (NULL != comment) {
+      *comment = '\0';
+    }
+
+    char directive[16];
+    if (1 != sscanf(line, "%15s", directive)) {
+      continue;  // blank
+    }
+
+    u32 x, y, w, h;
+    if (0 == strcmp(directive, "size")) {
+      ASSERT_CONTEXT(
+          2 == sscanf(line, "%*s %u %u", &self->m_width, &self->m_height) && self->m_width > 0 &&
+              self->m_height > 0,
+          "Invalid atlas size. file: %s:%u",
+          file,
+          lineNo)
+    } else if (0 == strcmp(directive, "region")) {
+      ASSERT_CONTEXT(
+          self->m_width > 0,
+          "Atlas region before size. file: %s:%u",
+          file,
+          lineNo)
+      ASSERT_CONTEXT(
+          4 == sscanf(line, "%*s %u %u %u %u", &x, &y, &w, &h),
+          "Invalid atlas region. file: %s:%u",
+          file,
+          lineNo)
+      ASSERT_CONTEXT(
+          self->m_count < ATLAS_REGIONS_CAP,
+          "Too many atlas regions. file: %s:%u, cap: %u",
+          file,
+          lineNo,
+          ATLAS_REGIONS_CAP)
+      AtlasRegion_t* region = &self->m_regions[self->m_count++];
+      memset(region, 0, sizeof(AtlasRegion_t));
+      region->u = (f32)x / self->m_width;
+      region->v = (f32)y / self->m_height;
+      region->w = (f32)w / self->m_width;
+      region->h = (f32)h / self->m_height;
+      regionW = w;
+      regionH = h;
+    } else if (0 == strcmp(directive, "mesh")) {
+      ASSERT_CONTEXT(
+          self->m_count > 0 && 0 == self->m_regions[self->m_count - 1].meshCount,
+          "Atlas mesh without a region. file: %s:%u",
+          file,
+          lineNo)
+      f32 numbers[MESH_INPUT_CAP];
+      u32 numbersCount = 0;
+      const char* cursor = line + strspn(line, " \t") + strlen(directive);
+      s32 read;
+      while (numbersCount < MESH_INPUT_CAP &&
+             1 == sscanf(cursor, "%f%n", &numbers[numbersCount], &read)) {
+        cursor += read;
+        numbersCount++;
+      }
+      ASSERT_CONTEXT(
+          0 == numbersCount % 2 && numbersCount >= 3 * 2 && numbersCount <= ATLAS_MESH_CAP * 2,
+          "Invalid atlas mesh. file: %s:%u, numbers: %u",
+          file,
+          lineNo,
+          numbersCount)
+      // pixels from the region's top-left, to the quad's space; see simple_shader.vert
+      AtlasRegion_t* region = &self->m_regions[self->m_count - 1];
+      region->meshCount = numbersCount / 2;
+      for (u32 i = 0; i < ATLAS_MESH_CAP; i++) {
+        const u32 n = MATH_MIN(i, region->meshCount - 1) * 2;
+        region->mesh[i][0] = 0.5f - numbers[n] / regionW;
+        region->mesh[i][1] = numbers[n + 1] / regionH - 0.5f;
+      }
+    } else {
+      ASSERT_CONTEXT(
+          false,
+          "Unknown atlas directive. file: %s:%u, directive: %s",
+          file,
+          lineNo,
+          directive)
+    }
+  }
+  fclose(fh);
+
+  ASSERT_CONTEXT(self->m_count > 0, "Atlas has no regions. file: %s", file)
+  LOG_DEBUGF("atlas regions: %u", self->m_count)
+}
+
+void Atlas__Shutdown(Atlas_t* self) {
+  free(self->m_regions);
+  memset(self, 0, sizeof(Atlas_t));
+}
+
+typedef struct {
+  f64 x;
+  f64 y;
+} Point_t;
+
+static f64 Cross(Point_t o, Point_t a, Point_t b) {
+  return (a.x - o.x) * (b.y - o.y) - (a.y - o.y) * (b.x - o.x);
+}
+
+static int ComparePoints(const void* a, const void* b) {
+  const Point_t* p = a;
+  const Point_t* q = b;
+  if (p->x != q->x) {
+    return p->x < q->x ? -1 : 1;
+  }
+  return p->y < q->y ? -1 : p->y > q->y ? 1 : 0;
+}
+
+/**
+ * Convex hull of the given points, by monotone chain; collinear points are dropped.
+ * hull must hold count + 1 points. Returns the vertex count, counter-clockwise on screen.
+ */
+static u32 ConvexHull(Point_t* points, u32 count, Point_t* hull) {
+  qsort(points, count, sizeof(Point_t), ComparePoints);
+  u32 n = 0;
+  for (u32 i = 0; i < count; i++) {
+    while (n >= 2 && Cross(hull[n - 2], hull[n - 1], points[i]) >= 0) {
+      n--;
+    }
+    hull[n++] = points[i];
+  }
+  const u32 lower = n + 1;
+  for (u32 i = count - 1; i-- > 0;) {
+    while (n >= lower && Cross(hull[n - 2], hull[n - 1], points[i]) >= 0) {
+      n--;
+    }
+    hull[n++] = points[i];
+  }
+  return n - 1;  // the last point is the first again
+}
+
+/**
+ * Cut a convex polygon down to at most max vertices, only ever growing it, so it still covers
+ * what it did. Each step drops the edge whose neighbours, extended to meet, add the least area.
+ * The polygon may not grow past w by h. Returns the vertex count, or 0 if it can't get there.
+ */
+static u32 ReduceHull(Point_t* hull, u32 count, u32 max, f64 w, f64 h) {
+  while (count > max) {
+    u32 best = count;
+    f64 bestArea = 0;
+    Point_t bestPoint = {0, 0};
+    for (u32 i = 0; i < count; i++) {
+      const Point_t a = hull[(i + count - 1) % count];
+      const Point_t b = hull[i];
+      const Point_t c = hull[(i + 1) % count];
+      const Point_t d = hull[(i + 2) % count];
+      // where a->b, carried on, meets d->c, carried on
+      const Point_t ab = {b.x - a.x, b.y - a.y};
+      const Point_t dc = {c.x - d.x, c.y - d.y};
+      const Point_t bc = {c.x - b.x, c.y - b.y};
+      const f64 denom = ab.x * dc.y - ab.y * dc.x;
+      if (0 == denom) {
+        continue;
+      }
+      const f64 s = (bc.x * dc.y - bc.y * dc.x) / denom;
+      const f64 t = (bc.x * ab.y - bc.y * ab.x) / denom;
+      if (s <= 0 || t <= 0) {
+        continue;  // they diverge
+      }
+      const Point_t p = {b.x + s * ab.x, b.y + s * ab.y};
+      if (p.x < -0.01 || p.y < -0.01 || p.x > w + 0.01 || p.y > h + 0.01) {
+        continue;
+      }
+      const f64 area = (Cross(b, p, c) < 0 ? -1 : 1) * Cross(b, p, c) / 2;
+      if (best == count || area < bestArea) {
+        best = i;
+        bestArea = area;
+        bestPoint = p;
+      }
+    }
+    if (best == count) {
+      return 0;
+    }
+
+    // b becomes the meeting point, and c goes
+    hull[best] = bestPoint;
+    const u32 drop = (best + 1) % count;
+    memmove(&hull[drop], &hull[drop + 1], (count - drop - 1) * sizeof(Point_t));
+    count--;
+  }
+  return count;
+}
+
+static f64 Area(const Point_t* polygon, u32 count) {
+  f64 area = 0;
+  for (u32 i = 0; i < count; i++) {
+    const Point_t a = polygon[i];
+    const Point_t b = polygon[(i + 1) % count];
+    area += a.x * b.y - b.x * a.y;
+  }
+  return (area < 0 ? -area : area) / 2;
+}
+
+/**
+ * Fit a mesh to the pixels of a region with any alpha, in pixels from its top-left.
+ * Returns the vertex count, or 0 when the whole quad is as good.
+ */
+static u32 FitMesh(
+    const u8* rgba, u32 stride, u32 x, u32 y, u32 w, u32 h, Point_t* scratch, Point_t* mesh) {
+  // each row's leftmost and rightmost pixel, by their outer corners, bounds the row exactly
+  u32 count = 0;
+  for (u32 row = 0; row < h; row++) {
+    const u8* pixels = &rgba[((u64)(y + row) * stride + x) * 4];
+    u32 left = w;
+    u32 right = 0;
+    for (u32 col = 0; col < w; col++) {
+      if (pixels[col * 4 + 3] > 0) {
+        left = MATH_MIN(left, col);
+        right = col + 1;
+      }
+    }
+    if (left < right) {
+      scratch[count++] = (Point_t){left, row};
+      scratch[count++] = (Point_t){left, row + 1};
+      scratch[count++] = (Point_t){right, row};
+      scratch[count++] = (Point_t){right, row + 1};
+    }
+  }
+  if (0 == count) {
+    return 0;
+  }
+
+  u32 n = ConvexHull(scratch, count, mesh);
+  n = ReduceHull(mesh, n, ATLAS_MESH_CAP, w, h);
+  if (n < 3 || Area(mesh, n) > MESH_MAX_AREA * w * h) {
+    return 0;
+  }
+  return n;
+}
+
+/**
+ * Offline: fit a mesh to every region of an atlas file, from the atlas image's alpha, and write
+ * them back into the file as mesh directives; any there before are replaced. The rest of the
+ * file, comments too, is kept as it was. Returns false if it couldn't be written.
+ */
+bool Atlas__BakeMeshes(const char* file, const u8* rgba, u32 width, u32 height) {
+  LOG_INFOF("baking atlas meshes: %s", file)
+
+  FILE* fh;
+  ASSERT(0 == fopen_s(&fh, file, "r"))
+  ASSERT(NULL != fh)
+  fseek(fh, 0, SEEK_END);
+  const u64 inSize = (u64)ftell(fh);
+  fseek(fh, 0, SEEK_SET);
+
+  // no more lines than bytes, and each may gain a mesh line of at most this long
+  const u64 meshLineCap = 8 + ATLAS_MESH_CAP * 2 * 12;
+  char* out = malloc(inSize * (1 + meshLineCap) + 1);
+  u32 scratchCap = 0;
+  Point_t* scratch = NULL;
+  Point_t* mesh = NULL;
+  ASSERT(out)
+
+  u64 outSize = 0;
+  u32 meshes = 0;
+  f64 scaleX = 0;  // image pixels per atlas pixel; the image may be resized since it was measured
+  f64 scaleY = 0;
+  char line[256];
+  u32 lineNo = 0;
+  while (NULL != fgets(line, sizeof(line), fh)) {
+    lineNo++;
+    char directive[16];
+    if (1 == sscanf(line, "%15s", directive) && 0 == strcmp(directive, "mesh")) {
+      continue;
+    }
+    const u64 lineSize = strlen(line);
+    memcpy(&out[outSize], line, lineSize);
+    outSize += lineSize;
+
+    if (1 != sscanf(line, "%15s", directive)) {
+      continue;  // blank
+    }
+    u32 x, y, w, h;
+    if (0 == strcmp(directive, "size")) {
+      const s32 read = sscanf(line, "%*s %u %u", &w, &h);
+      ASSERT_CONTEXT(2 == read && w > 0 && h > 0, "Invalid atlas size. file: %s:%u", file, lineNo)
+      scaleX = (f64)width / w;
+      scaleY = (f64)height / h;
+    } else if (0 == strcmp(directive, "region")) {
+      const s32 read = sscanf(line, "%*s %u %u %u %u", &x, &y, &w, &h);
+      ASSERT_CONTEXT(
+          4 == read && scaleX > 0,
+          "Invalid atlas region. file: %s:%u",
+          file,
+          lineNo)
+      // the image pixels the region covers, any part of
+      const u32 imageX = (u32)(x * scaleX);
+      const u32 imageY = (u32)(y * scaleY);
+      const u32 imageW = MATH_MIN((u32)ceil((x + w) * scaleX), width) - imageX;
+      const u32 imageH = MATH_MIN((u32)ceil((y + h) * scaleY), height) - imageY;
+      if (imageH * 4 > scratchCap) {
+        scratchCap = imageH * 4;
+        scratch = realloc(scratch, scratchCap * sizeof(Point_t));
+        mesh = realloc(mesh, (scratchCap + 1) * sizeof(Point_t));
+        ASSERT(scratch && mesh)
+      }
+      const u32 n = FitMesh(rgba, width, imageX, imageY, imageW, imageH, scratch, mesh);
+      for (u32 i = 0; i < n; i++) {
+        mesh[i].x = MATH_MIN(MATH_MAX((imageX + mesh[i].x) / scaleX - x, 0), w);
+        mesh[i].y = MATH_MIN(MATH_MAX((imageY + mesh[i].y) / scaleY - y, 0), h);
+      }
+      if (n > 0) {
+        if (outSize > 0 && '\n' != out[outSize - 1]) {
+          out[outSize++] = '\n';
+        }
+        outSize += sprintf(&out[outSize], "mesh");
+        for (u32 i = 0; i < n; i++) {
+          outSize += sprintf(&out[outSize], " %.2f %.2f", mesh[i].x, mesh[i].y);
+        }
+        out[outSize++] = '\n';
+        meshes++;
+        LOG_DEBUGF(
+            "atlas mesh: line %u, %u vertices, %.0f%% of the quad",
+            lineNo,
+            n,
+            Area(mesh, n) * 100 / ((f64)w * h))
+      }
+    }
+  }
+  fclose(fh);
+  free(scratch);
+  free(mesh);
+
+  const void* datas[] = {out};
+  const u64 sizes[] = {outSize};
+  const bool ok = File__WriteAll(file, 1, datas, sizes);
+  free(out);
+  LOG_INFOF("baked atlas meshes: %u", meshes)
+  return ok;
+}
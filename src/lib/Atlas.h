@@ -0,0 +1,45 @@
+#ifndef ATLAS_H
+#define ATLAS_H
+
+// An atlas is the table of sprite regions packed into one texture
+// it is loaded from a metadata file beside the texture, and uploaded as-is for the shaders.
+// - a region's index in the file is its texId
+// - regions are stored normalized (0..1 of the atlas), so the shader does one fetch per vertex
+// - a region may have a mesh; a convex polygon around its opaque pixels, drawn instead of the
+//   whole quad so transparent borders aren't shaded. Atlas__BakeMeshes() fits them offline
+//
+// file format; one directive per line, # starts a comment
+//   size <width> <height>          pixel size the regions were measured against; must come first
+//   region <x> <y> <w> <h> [name]  pixels, from the top-left
+//   mesh <x> <y> ...               3 to ATLAS_MESH_CAP pixels, from the region's top-left; in
+//                                  order, counter-clockwise on screen. for the region before
+
+#include "Base.h"
+
+#define ATLAS_REGIONS_CAP 4096
+#define ATLAS_MESH_CAP 8  // vertices; every sprite is drawn as a fan over this many
+
+// matches AtlasRegion in simple_shader.vert
+typedef struct {
+  f32 u;
+  f32 v;
+  f32 w;
+  f32 h;
+  // in the sprite quad's space, ie. -0.5..+0.5; past meshCount, repeats the last vertex
+  f32 mesh[ATLAS_MESH_CAP][2];
+  u32 meshCount;  // 0 draws the whole quad
+  u32 pad[3];
+} AtlasRegion_t;
+
+typedef struct {
+  u32 m_width;
+  u32 m_height;
+  u32 m_count;
+  AtlasRegion_t* m_regions;
+} Atlas_t;
+
+void Atlas__Load(Atlas_t* self, const char* file);
+void Atlas__Shutdown(Atlas_t* self);
+bool Atlas__BakeMeshes(const char* file, const u8* rgba, u32 width, u32 height);
+
+#endif
@@ -0,0 +1,141 @@
+#include "File.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#if OS_WINDOWS != 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+/**
+ * Map a whole file for reading. Returns false, leaving self empty, if it can't be opened.
+ */
+bool File__Map(File__Mapping_t* self, const char* path) {
+  memset(self, 0, sizeof(File__Mapping_t));
+#if OS_WINDOWS == 1
+  self->file = CreateFileA(
+      path,
+      GENERIC_READ,
+      FILE_SHARE_READ,
+      NULL,
+      OPEN_EXISTING,
+      FILE_ATTRIBUTE_NORMAL,
+      NULL);
+  if (INVALID_HANDLE_VALUE == self->file) {
+    self->file = NULL;
+    return false;
+  }
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(self->file, &size) || 0 == size.QuadPart) {
+    File__Unmap(self);
+    return false;
+  }
+  self->size = (u64)size.QuadPart;
+  self->mapping = CreateFileMappingA(self->file, NULL, PAGE_READONLY, 0, 0, NULL);
+  if (NULL == self->mapping) {
+    File__Unmap(self);
+    return false;
+  }
+  self->data = MapViewOfFile(self->mapping, FILE_MAP_READ, 0, 0, 0);
+  if (NULL == self->data) {
+    File__Unmap(self);
+    return false;
+  }
+#else
+  const int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat st;
+  if (0 != fstat(fd, &st) || 0 == st.st_size) {
+    close(fd);
+    return false;
+  }
+  void* data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  // the mapping holds its own reference to the file
+  close(fd);
+  if (MAP_FAILED == data) {
+    return false;
+  }
+  self->data = data;
+  self->size = (u64)st.st_size;
+#endif
+  return true;
+}
+
+void File__Unmap(File__Mapping_t* self) {
+#if OS_WINDOWS == 1
+  if (self->data) {
+    UnmapViewOfFile(self->data);
+  }
+  if (self->mapping) {
+    CloseHandle(self->mapping);
+  }
+  if (self->file) {
+    CloseHandle(self->file);
+  }
+#else
+  if (self->data) {
+    munmap(self->data, (size_t)self->size);
+  }
+#endif
+  memset(self, 0, sizeof(File__Mapping_t));
+}
+
+/**
+ * Write the given pieces, in order, as the whole contents of path.
+ */
+bool File__WriteAll(const char* path, u32 count, const void* datas[], const u64 sizes[]) {
+  char tmp[FILE_PATH_CAP];
+  if (snprintf(tmp, sizeof(tmp), "%s.tmp", path) >= (int)sizeof(tmp)) {
+    return false;
+  }
+
+  FILE* fh;
+  if (0 != fopen_s(&fh, tmp, "wb") || NULL == fh) {
+    return false;
+  }
+  bool ok = true;
+  for (u32 i = 0; i < count && ok; i++) {
+    ok = sizes[i] == fwrite(datas[i], 1, sizes[i], fh);
+  }
+  ok = 0 == fclose(fh) && ok;
+
+#if OS_WINDOWS == 1
+  ok = ok && MoveFileExA(tmp, path, MOVEFILE_REPLACE_EXISTING);
+#else
+  ok = ok && 0 == rename(tmp, path);
+#endif
+  if (!ok) {
+    remove(tmp);
+  }
+  return ok;
+}
+
+void File__Evict(const char* path) {
+#if OS_LINUX == 1 || OS_ANDROID == 1
+  const int fd = open(path, O_RDONLY);
+  if (fd >= 0) {
+    // only clean pages are dropped; flush any still being written back first
+    fdatasync(fd);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+  }
+#else
+  (void)path;
+#endif
+}
+
+/**
+ * FNV-1a; chain calls by passing the previous result, starting from FILE_HASH_SEED.
+ */
+u64 File__Hash(u64 hash, const void* data, u64 size) {
+  const u8* bytes = data;
+  for (u64 i = 0; i < size; i++) {
+    hash ^= bytes[i];
+    hash *= 0x100000001b3ull;
+  }
+  return hash;
+}
@@ -0,0 +1,30 @@
+#ifndef FILE_H
+#define FILE_H
+
+// A file mapping is a read-only view of a whole file in memory
+// pages are read in on first touch, so mapping is cheap, and the OS page cache backs it.
+// - File__WriteAll() writes beside the target, then renames over it; readers never see half a file
+// - File__Evict() drops a file from the page cache, to measure cold reads; best effort, and
+//   a no-op where the OS offers no way to do it
+
+#include "Base.h"
+
+#define FILE_PATH_CAP 260
+#define FILE_HASH_SEED 0xcbf29ce484222325ull
+
+typedef struct {
+  void* data;
+  u64 size;
+#if OS_WINDOWS == 1
+  HANDLE file;
+  HANDLE mapping;
+#endif
+} File__Mapping_t;
+
+bool File__Map(File__Mapping_t* self, const char* path);
+void File__Unmap(File__Mapping_t* self);
+bool File__WriteAll(const char* path, u32 count, const void* datas[], const u64 sizes[]);
+void File__Evict(const char* path);
+u64 File__Hash(u64 hash, const void* data, u64 size);
+
+#endif
@@ -0,0 +1,167 @@
+#include "Grid.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+static u32 Hash(s32 cx, s32 cy) {
+  return (((u32)cx * 73856093u) ^ ((u32)cy * 19349663u)) & (GRID_BUCKETS_CAP - 1);
+}
+
+static u32 BucketPush(GridBucket_t* bucket, u32 id) {
+  if (bucket->count == bucket->cap) {
+    const u32 cap = MATH_MAX(bucket->cap * 2, 8);
+    u32* ids = realloc(bucket->ids, cap * sizeof(u32));
+    ASSERT_CONTEXT(ids, "Out of memory growing grid bucket. cap: %u", cap)
+    bucket->ids = ids;
+    bucket->cap = cap;
+  }
+  bucket->ids[bucket->count] = id;
+  return bucket->count++;
+}
+
+static GridBucket_t* ItemBucket(Grid_t* self, GridItem_t* item) {
+  return GRID_OVERSIZED == item->bucket ? &self->m_oversized : &self->m_buckets[item->bucket];
+}
+
+static void Link(Grid_t* self, u32 id) {
+  GridItem_t* item = &self->m_items[id];
+  if (2 * item->hw > self->m_cellSize || 2 * item->hh > self->m_cellSize) {
+    item->bucket = GRID_OVERSIZED;
+  } else {
+    item->cx = (s32)floorf(item->x / self->m_cellSize);
+    item->cy = (s32)floorf(item->y / self->m_cellSize);
+    item->bucket = Hash(item->cx, item->cy);
+  }
+  item->slot = BucketPush(ItemBucket(self, item), id);
+}
+
+static void Unlink(Grid_t* self, u32 id) {
+  GridItem_t* item = &self->m_items[id];
+  GridBucket_t* bucket = ItemBucket(self, item);
+  const u32 last = bucket->ids[--bucket->count];
+  bucket->ids[item->slot] = last;
+  self->m_items[last].slot = item->slot;
+  item->bucket = GRID_NONE;
+}
+
+static bool Overlaps(const GridItem_t* item, f32 minX, f32 minY, f32 maxX, f32 maxY) {
+  return item->x + item->hw >= minX && item->x - item->hw <= maxX && item->y + item->hh >= minY &&
+         item->y - item->hh <= maxY;
+}
+
+static int CompareIds(const void* a, const void* b) {
+  const u32 x = *(const u32*)a;
+  const u32 y = *(const u32*)b;
+  return (x > y) - (x < y);
+}
+
+void Grid__New(Grid_t* self, f32 cellSize) {
+  memset(self, 0, sizeof(Grid_t));
+  self->m_cellSize = cellSize;
+}
+
+void Grid__Insert(Grid_t* self, u32 id, f32 x, f32 y, f32 hw, f32 hh) {
+  if (id >= self->m_itemsCap) {
+    const u32 cap = MATH_MAX(MATH_MAX(self->m_itemsCap * 2, id + 1), 256);
+    GridItem_t* items = realloc(self->m_items, cap * sizeof(GridItem_t));
+    ASSERT_CONTEXT(items, "Out of memory growing grid items. cap: %u", cap)
+    for (u32 i = self->m_itemsCap; i < cap; i++) {
+      items[i].bucket = GRID_NONE;
+    }
+    self->m_items = items;
+    self->m_itemsCap = cap;
+  }
+  ASSERT_CONTEXT(GRID_NONE == self->m_items[id].bucket, "Grid item already inserted. id: %u", id)
+
+  GridItem_t* item = &self->m_items[id];
+  item->x = x;
+  item->y = y;
+  item->hw = hw;
+  item->hh = hh;
+  Link(self, id);
+}
+
+void Grid__Move(Grid_t* self, u32 id, f32 x, f32 y) {
+  GridItem_t* item = &self->m_items[id];
+  item->x = x;
+  item->y = y;
+  if (GRID_OVERSIZED == item->bucket) {
+    return;
+  }
+  const s32 cx = (s32)floorf(x / self->m_cellSize);
+  const s32 cy = (s32)floorf(y / self->m_cellSize);
+  if (cx != item->cx || cy != item->cy) {
+    Unlink(self, id);
+    Link(self, id);
+  }
+}
+
+void Grid__Remove(Grid_t* self, u32 id) {
+  if (id < self->m_itemsCap && GRID_NONE != self->m_items[id].bucket) {
+    Unlink(self, id);
+  }
+}
+
+/**
+ * Find every item whose box overlaps the given rectangle.
+ * Returns the count; ids receives them in ascending order, valid until the next query.
+ */
+u32 Grid__Query(Grid_t* self, f32 minX, f32 minY, f32 maxX, f32 maxY, const u32** ids) {
+  GridBucket_t* results = &self->m_results;
+  results->count = 0;
+
+  for (u32 i = 0; i < self->m_oversized.count; i++) {
+    const u32 id = self->m_oversized.ids[i];
+    if (Overlaps(&self->m_items[id], minX, minY, maxX, maxY)) {
+      BucketPush(results, id);
+    }
+  }
+
+  // items reach at most half a cell past the cell holding their center
+  const f32 pad = self->m_cellSize / 2;
+  const s32 x0 = (s32)floorf((minX - pad) / self->m_cellSize);
+  const s32 y0 = (s32)floorf((minY - pad) / self->m_cellSize);
+  const s32 x1 = (s32)floorf((maxX + pad) / self->m_cellSize);
+  const s32 y1 = (s32)floorf((maxY + pad) / self->m_cellSize);
+
+  if ((u64)(x1 - x0 + 1) * (u64)(y1 - y0 + 1) > GRID_BUCKETS_CAP) {
+    // zoomed out past the table size; a flat scan of every bucket is cheaper
+    for (u32 b = 0; b < GRID_BUCKETS_CAP; b++) {
+      for (u32 i = 0; i < self->m_buckets[b].count; i++) {
+        const u32 id = self->m_buckets[b].ids[i];
+        if (Overlaps(&self->m_items[id], minX, minY, maxX, maxY)) {
+          BucketPush(results, id);
+        }
+      }
+    }
+  } else {
+    for (s32 cy = y0; cy <= y1; cy++) {
+      for (s32 cx = x0; cx <= x1; cx++) {
+        const GridBucket_t* bucket = &self->m_buckets[Hash(cx, cy)];
+        for (u32 i = 0; i < bucket->count; i++) {
+          const u32 id = bucket->ids[i];
+          const GridItem_t* item = &self->m_items[id];
+          // skip hash collisions; also keeps each item to one visit
+          if (item->cx == cx && item->cy == cy && Overlaps(item, minX, minY, maxX, maxY)) {
+            BucketPush(results, id);
+          }
+        }
+      }
+    }
+  }
+
+  qsort(results->ids, results->count, sizeof(u32), CompareIds);
+  *ids = results->ids;
+  return results->count;
+}
+
+void Grid__Shutdown(Grid_t* self) {
+  for (u32 b = 0; b < GRID_BUCKETS_CAP; b++) {
+    free(self->m_buckets[b].ids);
+  }
+  free(self->m_oversized.ids);
+  free(self->m_results.ids);
+  free(self->m_items);
+  memset(self, 0, sizeof(Grid_t));
+}
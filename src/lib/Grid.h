@@ -0,0 +1,54 @@
+#ifndef GRID_H
+#define GRID_H
+
+// A uniform grid is a spatial index over 2D axis-aligned boxes
+// each item lives in the one cell containing its center,
+// and cells are hashed into a fixed number of buckets, so the world is unbounded.
+// - insert, move and remove are O(1); removal swaps the last item of a bucket into the hole
+// - items wider than a cell go into a separate list, which every query scans
+// - queries return ids in ascending order, so callers keep their draw order
+
+#include "Base.h"
+
+#define GRID_BUCKETS_CAP 4096  // must be a power of two
+#define GRID_NONE UINT32_MAX
+#define GRID_OVERSIZED (UINT32_MAX - 1)
+
+typedef struct {
+  f32 x;
+  f32 y;
+  f32 hw;  // half-width
+  f32 hh;  // half-height
+  s32 cx;
+  s32 cy;
+  u32 bucket;  // or GRID_OVERSIZED, or GRID_NONE when not inserted
+  u32 slot;    // index within the bucket
+} GridItem_t;
+
+typedef struct {
+  u32* ids;
+  u32 count;
+  u32 cap;
+} GridBucket_t;
+
+typedef struct {
+  f32 m_cellSize;
+  GridBucket_t m_buckets[GRID_BUCKETS_CAP];
+  GridBucket_t m_oversized;
+
+  // indexed by id
+  GridItem_t* m_items;
+  u32 m_itemsCap;
+
+  // reused by every query
+  GridBucket_t m_results;
+} Grid_t;
+
+void Grid__New(Grid_t* self, f32 cellSize);
+void Grid__Insert(Grid_t* self, u32 id, f32 x, f32 y, f32 hw, f32 hh);
+void Grid__Move(Grid_t* self, u32 id, f32 x, f32 y);
+void Grid__Remove(Grid_t* self, u32 id);
+u32 Grid__Query(Grid_t* self, f32 minX, f32 minY, f32 maxX, f32 maxY, const u32** ids);
+void Grid__Shutdown(Grid_t* self);
+
+#endif
@@ -0,0 +1,246 @@
+#include "Instances.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE__) || defined(_M_X64)
+#include <xmmintrin.h>
+#define INSTANCES_SSE 1
+#endif
+
+void Instances__New(Instances_t* self, u32 cap) {
+  self->m_data = calloc(cap, sizeof(Instance_t));
+  self->m_gpu = calloc(cap, sizeof(InstanceGpu_t));
+  ASSERT(self->m_data && self->m_gpu)
+  memset(&self->m_soa, 0, sizeof(Instances__SoA_t));
+  self->m_count = 0;
+  self->m_cap = cap;
+  self->m_dirtyCount = 0;
+}
+
+/**
+ * Append a zeroed instance, marked dirty. Returns its index.
+ * NOTICE: storage may move; re-read m_data after calling.
+ */
+u32 Instances__Add(Instances_t* self) {
+  if (self->m_count == self->m_cap) {
+    // grow geometrically, so appends stay amortized O(1)
+    ASSERT_CONTEXT(self->m_cap <= UINT32_MAX / 2, "Too many instances. cap: %u", self->m_cap)
+    const u32 cap = MATH_MAX(self->m_cap * 2, INSTANCES_MIN_CAP);
+    Instance_t* data = realloc(self->m_data, cap * sizeof(Instance_t));
+    InstanceGpu_t* gpu = realloc(self->m_gpu, cap * sizeof(InstanceGpu_t));
+    ASSERT_CONTEXT(data && gpu, "Out of memory growing instances. cap: %u", cap)
+    self->m_data = data;
+    self->m_gpu = gpu;
+    self->m_cap = cap;
+  }
+  const u32 idx = self->m_count++;
+  memset(&self->m_data[idx], 0, sizeof(Instance_t));
+  Instances__MarkDirty(self, idx, 1);
+  return idx;
+}
+
+static void RemoveRange(Instances__Range_t* ranges, u32* rangesCount, u32 i) {
+  memmove(&ranges[i], &ranges[i + 1], (*rangesCount - i - 1) * sizeof(Instances__Range_t));
+  (*rangesCount)--;
+}
+
+/**
+ * Add a range to a sorted set of at most INSTANCES_DIRTY_RANGES_CAP, merging it as the dirty
+ * ranges are; see Instances.h.
+ */
+void Instances__AddRange(Instances__Range_t* ranges, u32* rangesCount, u32 first, u32 count) {
+  if (0 == count) {
+    return;
+  }
+  u32 end = first + count;
+
+  if (*rangesCount == INSTANCES_DIRTY_RANGES_CAP) {
+    // out of slots; merge the pair of neighbors with the smallest gap between them
+    u32 best = 0;
+    u32 bestGap = UINT32_MAX;
+    for (u32 i2 = 0; i2 + 1 < *rangesCount; i2++) {
+      const u32 gap = ranges[i2 + 1].first - (ranges[i2].first + ranges[i2].count);
+      if (gap < bestGap) {
+        bestGap = gap;
+        best = i2;
+      }
+    }
+    ranges[best].count = ranges[best + 1].first + ranges[best + 1].count - ranges[best].first;
+    RemoveRange(ranges, rangesCount, best + 1);
+  }
+
+  // find the first range which ends at or after (first - gap); everything before stays
+  u32 i = 0;
+  while (i < *rangesCount && ranges[i].first + ranges[i].count + INSTANCES_DIRTY_GAP < first) {
+    i++;
+  }
+
+  // absorb every range which starts within (end + gap)
+  while (i < *rangesCount && ranges[i].first <= end + INSTANCES_DIRTY_GAP) {
+    first = MATH_MIN(first, ranges[i].first);
+    end = MATH_MAX(end, ranges[i].first + ranges[i].count);
+    RemoveRange(ranges, rangesCount, i);
+  }
+
+  memmove(&ranges[i + 1], &ranges[i], (*rangesCount - i) * sizeof(Instances__Range_t));
+  ranges[i].first = first;
+  ranges[i].count = end - first;
+  (*rangesCount)++;
+}
+
+void Instances__MarkDirty(Instances_t* self, u32 first, u32 count) {
+  Instances__AddRange(self->m_dirty, &self->m_dirtyCount, first, count);
+}
+
+void Instances__ClearDirty(Instances_t* self) {
+  self->m_dirtyCount = 0;
+}
+
+static void GrowSoA(Instances__SoA_t* soa, u32 count) {
+  if (count <= soa->cap) {
+    return;
+  }
+  const u32 cap = MATH_MAX(count, soa->cap * 2);
+  f32** arrays[] = {
+      &soa->px, &soa->py, &soa->pz, &soa->rx, &soa->ry, &soa->rz, &soa->sx, &soa->sy, &soa->sz};
+  for (u32 i = 0; i < ARRAY_COUNT(arrays); i++) {
+    *arrays[i] = realloc(*arrays[i], cap * sizeof(f32));
+    ASSERT_CONTEXT(*arrays[i], "Out of memory growing instance transforms. cap: %u", cap)
+  }
+  soa->cap = cap;
+}
+
+/**
+ * Recompute the GPU copy of every dirty instance. Call before uploading the dirty ranges.
+ */
+void Instances__UpdateTransforms(Instances_t* self) {
+  for (u32 r = 0; r < self->m_dirtyCount; r++) {
+    const Instances__Range_t* range = &self->m_dirty[r];
+    GrowSoA(&self->m_soa, range->count);
+
+    Instances__SoA_t* soa = &self->m_soa;
+    for (u32 i = 0; i < range->count; i++) {
+      const Instance_t* instance = &self->m_data[range->first + i];
+      soa->px[i] = instance->pos[0];
+      soa->py[i] = instance->pos[1];
+      soa->pz[i] = instance->pos[2];
+      soa->rx[i] = instance->rot[0];
+      soa->ry[i] = instance->rot[1];
+      soa->rz[i] = instance->rot[2];
+      soa->sx[i] = instance->scale[0];
+      soa->sy[i] = instance->scale[1];
+      soa->sz[i] = instance->scale[2];
+      self->m_gpu[range->first + i].texId = instance->texId;
+      self->m_gpu[range->first + i].texture = instance->texture;
+    }
+
+    Instances__TransformKernel(soa, range->count, &self->m_gpu[range->first]);
+  }
+}
+
+// model = translate(pos) * rotX * rotY * rotZ * scale(scale),
+// with rotations matching the column-major constructors formerly in simple_shader.vert
+static void TransformScalar(const Instances__SoA_t* in, u32 i, InstanceGpu_t* out) {
+  const f32 cx = cosf(in->rx[i]), sx = sinf(in->rx[i]);
+  const f32 cy = cosf(in->ry[i]), sy = sinf(in->ry[i]);
+  const f32 cz = cosf(in->rz[i]), sz = sinf(in->rz[i]);
+  f32* m = out->model;
+  m[0] = cy * cz * in->sx[i];
+  m[1] = cy * sz * in->sy[i];
+  m[2] = -sy * in->sz[i];
+  m[3] = in->px[i];
+  m[4] = (sx * sy * cz - cx * sz) * in->sx[i];
+  m[5] = (sx * sy * sz + cx * cz) * in->sy[i];
+  m[6] = sx * cy * in->sz[i];
+  m[7] = in->py[i];
+  m[8] = (cx * sy * cz + sx * sz) * in->sx[i];
+  m[9] = (cx * sy * sz - sx * cz) * in->sy[i];
+  m[10] = cx * cy * in->sz[i];
+  m[11] = in->pz[i];
+}
+
+/**
+ * Compute model matrices for count instances; four at a time, with a scalar tail.
+ */
+void Instances__TransformKernel(const Instances__SoA_t* in, u32 count, InstanceGpu_t* out) {
+  u32 i = 0;
+#if INSTANCES_SSE == 1
+  const __m128 zero = _mm_setzero_ps();
+  for (; i + 4 <= count; i += 4) {
+    const __m128 rx = _mm_loadu_ps(&in->rx[i]);
+    const __m128 ry = _mm_loadu_ps(&in->ry[i]);
+    const __m128 rz = _mm_loadu_ps(&in->rz[i]);
+    const __m128 rotated = _mm_or_ps(
+        _mm_or_ps(_mm_cmpneq_ps(rx, zero), _mm_cmpneq_ps(ry, zero)),
+        _mm_cmpneq_ps(rz, zero));
+    if (0 != _mm_movemask_ps(rotated)) {
+      // rare; sin/cos have no SSE intrinsic
+      for (u32 lane = 0; lane < 4; lane++) {
+        TransformScalar(in, i + lane, &out[i + lane]);
+      }
+      continue;
+    }
+
+    // unrotated: a diagonal scale plus translation, transposed from lanes into rows
+    __m128 c0 = _mm_loadu_ps(&in->sx[i]);
+    __m128 c1 = zero;
+    __m128 c2 = zero;
+    __m128 c3 = _mm_loadu_ps(&in->px[i]);
+    _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+    _mm_storeu_ps(&out[i + 0].model[0], c0);
+    _mm_storeu_ps(&out[i + 1].model[0], c1);
+    _mm_storeu_ps(&out[i + 2].model[0], c2);
+    _mm_storeu_ps(&out[i + 3].model[0], c3);
+
+    c0 = zero;
+    c1 = _mm_loadu_ps(&in->sy[i]);
+    c2 = zero;
+    c3 = _mm_loadu_ps(&in->py[i]);
+    _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+    _mm_storeu_ps(&out[i + 0].model[4], c0);
+    _mm_storeu_ps(&out[i + 1].model[4], c1);
+    _mm_storeu_ps(&out[i + 2].model[4], c2);
+    _mm_storeu_ps(&out[i + 3].model[4], c3);
+
+    c0 = zero;
+    c1 = zero;
+    c2 = _mm_loadu_ps(&in->sz[i]);
+    c3 = _mm_loadu_ps(&in->pz[i]);
+    _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+    _mm_storeu_ps(&out[i + 0].model[8], c0);
+    _mm_storeu_ps(&out[i + 1].model[8], c1);
+    _mm_storeu_ps(&out[i + 2].model[8], c2);
+    _mm_storeu_ps(&out[i + 3].model[8], c3);
+  }
+#endif
+  for (; i < count; i++) {
+    TransformScalar(in, i, &out[i]);
+  }
+}
+
+void Instances__Shutdown(Instances_t* self) {
+  free(self->m_data);
+  self->m_data = NULL;
+  free(self->m_gpu);
+  self->m_gpu = NULL;
+  f32** arrays[] = {
+      &self->m_soa.px,
+      &self->m_soa.py,
+      &self->m_soa.pz,
+      &self->m_soa.rx,
+      &self->m_soa.ry,
+      &self->m_soa.rz,
+      &self->m_soa.sx,
+      &self->m_soa.sy,
+      &self->m_soa.sz};
+  for (u32 i = 0; i < ARRAY_COUNT(arrays); i++) {
+    free(*arrays[i]);
+    *arrays[i] = NULL;
+  }
+  self->m_soa.cap = 0;
+  self->m_count = 0;
+  self->m_cap = 0;
+  self->m_dirtyCount = 0;
+}
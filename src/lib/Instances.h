@@ -0,0 +1,80 @@
+#ifndef INSTANCES_H
+#define INSTANCES_H
+
+// An instance store is the CPU copy of the per-instance vertex buffer
+// it remembers which index ranges changed since the last upload,
+// so only those spans need to be copied to the GPU.
+// - ranges are kept sorted, and merged when they touch or overlap
+// - ranges separated by a small gap are merged too; one wider copy beats another region
+// - when out of range slots, the two closest ranges are merged
+// - Instances__AddRange() keeps any other set of ranges the same way
+// - storage grows geometrically; the GPU buffer follows via m_cap
+// - the GPU copy (m_gpu) carries each instance's final model matrix instead of pos/rot/scale;
+//   it is recomputed only for dirty ranges, by a 4-wide SIMD kernel over a SoA copy
+
+#include <cglm/types.h>
+
+#include "Base.h"
+
+#define INSTANCES_DIRTY_RANGES_CAP 32
+#define INSTANCES_DIRTY_GAP 4  // instances
+#define INSTANCES_MIN_CAP 256
+
+typedef struct {
+  vec3 pos;
+  vec3 rot;
+  vec3 scale;
+  u32 texId;    // atlas region
+  u32 texture;  // handle from Vulkan__NewTexture(); the sheet the region is cut from
+  // CPU only; blended back-to-front instead of alpha-tested
+  bool translucent;
+  u8 layer;  // CPU only; what it is drawn over and under, as the app defines; with translucent
+} Instance_t;
+
+// what the vertex shader reads per instance
+typedef struct {
+  f32 model[12];  // rows 0-2 of the affine model matrix; row 3 is implicitly 0,0,0,1
+  u32 texId;
+  u32 texture;
+} InstanceGpu_t;
+
+typedef struct {
+  u32 first;
+  u32 count;
+} Instances__Range_t;
+
+// structure-of-arrays scratch, fed to the transform kernel
+typedef struct {
+  f32* px;
+  f32* py;
+  f32* pz;
+  f32* rx;
+  f32* ry;
+  f32* rz;
+  f32* sx;
+  f32* sy;
+  f32* sz;
+  u32 cap;
+} Instances__SoA_t;
+
+typedef struct {
+  Instance_t* m_data;
+  InstanceGpu_t* m_gpu;
+  u32 m_count;
+  u32 m_cap;
+  Instances__SoA_t m_soa;
+
+  u32 m_dirtyCount;
+  Instances__Range_t m_dirty[INSTANCES_DIRTY_RANGES_CAP];
+} Instances_t;
+
+void Instances__New(Instances_t* self, u32 cap);
+u32 Instances__Add(Instances_t* self);
+void Instances__AddRange(Instances__Range_t* ranges, u32* rangesCount, u32 first, u32 count);
+void Instances__MarkDirty(Instances_t* self, u32 first, u32 count);
+void Instances__ClearDirty(Instances_t* self);
+void Instances__UpdateTransforms(Instances_t* self);
+void Instances__TransformKernel(const Instances__SoA_t* in, u32 count, InstanceGpu_t* out);
+void Instances__Shutdown(Instances_t* self);
+
+#endif
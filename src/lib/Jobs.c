@@ -0,0 +1,73 @@
+#include "Jobs.h"
+
+#include <SDL2/SDL.h>
+#include <string.h>
+
+static void RunShare(Jobs_t* self, u32 index) {
+  for (u32 job = index; job < self->m_count; job += self->m_threadsCount) {
+    self->m_fn(self->m_data, job);
+  }
+}
+
+static int WorkerMain(void* data) {
+  Jobs__Worker_t* worker = data;
+  Jobs_t* self = worker->jobs;
+  while (true) {
+    SDL_SemWait(worker->start);
+    if (self->m_quit) {
+      break;
+    }
+    RunShare(self, worker->index);
+    SDL_SemPost(self->m_done);
+  }
+  return 0;
+}
+
+void Jobs__New(Jobs_t* self, u32 threadsCount) {
+  memset(self, 0, sizeof(Jobs_t));
+  self->m_threadsCount = MATH_MIN(MATH_MAX(threadsCount, 1), JOBS_THREADS_CAP);
+  self->m_done = SDL_CreateSemaphore(0);
+  ASSERT_CONTEXT(self->m_done, "SDL_CreateSemaphore failed. error: %s", SDL_GetError())
+
+  // thread 0 is the caller
+  for (u32 i = 1; i < self->m_threadsCount; i++) {
+    Jobs__Worker_t* worker = &self->m_workers[i];
+    worker->jobs = self;
+    worker->index = i;
+    worker->start = SDL_CreateSemaphore(0);
+    ASSERT_CONTEXT(worker->start, "SDL_CreateSemaphore failed. error: %s", SDL_GetError())
+    worker->thread = SDL_CreateThread(WorkerMain, "job worker", worker);
+    ASSERT_CONTEXT(worker->thread, "SDL_CreateThread failed. error: %s", SDL_GetError())
+  }
+  LOG_DEBUGF("job threads: %u", self->m_threadsCount)
+}
+
+/**
+ * Call fn(data, job) for every job in [0, count), spread over the pool, and wait for all of them.
+ */
+void Jobs__Run(Jobs_t* self, u32 count, Jobs__Fn_t fn, void* data) {
+  self->m_fn = fn;
+  self->m_data = data;
+  self->m_count = count;
+
+  // wake only the workers that have a share
+  const u32 workers = MATH_MIN(count, self->m_threadsCount);
+  for (u32 i = 1; i < workers; i++) {
+    SDL_SemPost(self->m_workers[i].start);
+  }
+  RunShare(self, 0);
+  for (u32 i = 1; i < workers; i++) {
+    SDL_SemWait(self->m_done);
+  }
+}
+
+void Jobs__Shutdown(Jobs_t* self) {
+  self->m_quit = true;
+  for (u32 i = 1; i < self->m_threadsCount; i++) {
+    SDL_SemPost(self->m_workers[i].start);
+    SDL_WaitThread(self->m_workers[i].thread, NULL);
+    SDL_DestroySemaphore(self->m_workers[i].start);
+  }
+  SDL_DestroySemaphore(self->m_done);
+  memset(self, 0, sizeof(Jobs_t));
+}
@@ -0,0 +1,43 @@
+#ifndef JOBS_H
+#define JOBS_H
+
+// A job pool is a fixed set of worker threads for fork-join parallel loops
+// the calling thread takes part, so a pool of N threads starts N-1 workers.
+// - job i always runs on thread i % N; callers may key per-thread resources by job index
+//   when they run no more jobs than threads
+// - Jobs__Run() returns once every job has finished
+
+#include "Base.h"
+typedef struct SDL_Thread SDL_Thread;
+typedef struct SDL_semaphore SDL_sem;
+
+#define JOBS_THREADS_CAP 16
+
+typedef void (*Jobs__Fn_t)(void* data, u32 job);
+
+typedef struct Jobs_t Jobs_t;
+
+typedef struct {
+  Jobs_t* jobs;
+  u32 index;
+  SDL_Thread* thread;
+  SDL_sem* start;
+} Jobs__Worker_t;
+
+struct Jobs_t {
+  u32 m_threadsCount;
+  Jobs__Worker_t m_workers[JOBS_THREADS_CAP];
+  SDL_sem* m_done;
+  bool m_quit;
+
+  // the loop being run
+  Jobs__Fn_t m_fn;
+  void* m_data;
+  u32 m_count;
+};
+
+void Jobs__New(Jobs_t* self, u32 threadsCount);
+void Jobs__Run(Jobs_t* self, u32 count, Jobs__Fn_t fn, void* data);
+void Jobs__Shutdown(Jobs_t* self);
+
+#endif
@@ -0,0 +1,277 @@
+#include "Loader.h"
+
+#include <SDL2/SDL.h>
+#include <math.h>
+#include <stb_image.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * The cache file for a source image: its file name plus LOADER_CACHE_EXTENSION,
+ * in the working directory (ie. beside the build output).
+ */
+void Loader__CacheFile(const char* file, char* cacheFile, u32 cacheFileCap) {
+  const char* name = file;
+  for (const char* c = file; *c; c++) {
+    if ('/' == *c || '\\' == *c) {
+      name = c + 1;
+    }
+  }
+  snprintf(cacheFile, cacheFileCap, "%s%s", name, LOADER_CACHE_EXTENSION);
+}
+
+static u64 MipSize(u32 width, u32 height, u32 level) {
+  return (u64)MATH_MAX(width >> level, 1) * MATH_MAX(height >> level, 1) * 4;
+}
+
+/**
+ * Replace a decoded image's pixels with its full mip chain, level 0 first.
+ * Each texel averages a 2x2 block of the level above in linear space, weighted by alpha,
+ * so transparent texels don't darken sprite edges.
+ */
+static void GenerateMips(Loader__Image_t* image) {
+  const u32 width = image->width;
+  const u32 height = image->height;
+  u32 mipsCount = 1;
+  while (mipsCount < LOADER_MIPS_CAP && ((width >> mipsCount) > 0 || (height >> mipsCount) > 0)) {
+    mipsCount++;
+  }
+  u64 size = 0;
+  for (u32 level = 0; level < mipsCount; level++) {
+    size += MipSize(width, height, level);
+  }
+
+  u8* chain = malloc(size);
+  ASSERT_CONTEXT(chain, "Out of memory for mip chain. bytes: %llu", (unsigned long long)size)
+  memcpy(chain, image->pixels, MipSize(width, height, 0));
+  stbi_image_free(image->pixels);
+
+  f32 toLinear[256];
+  for (u32 i = 0; i < 256; i++) {
+    const f32 c = i / 255.0f;
+    toLinear[i] = c <= 0.04045f ? c / 12.92f : powf((c + 0.055f) / 1.055f, 2.4f);
+  }
+
+  const u8* src = chain;
+  u8* dst = chain + MipSize(width, height, 0);
+  for (u32 level = 1; level < mipsCount; level++) {
+    const u32 srcW = MATH_MAX(width >> (level - 1), 1);
+    const u32 srcH = MATH_MAX(height >> (level - 1), 1);
+    const u32 dstW = MATH_MAX(width >> level, 1);
+    const u32 dstH = MATH_MAX(height >> level, 1);
+    for (u32 y = 0; y < dstH; y++) {
+      for (u32 x = 0; x < dstW; x++) {
+        f32 rgb[3] = {0};
+        f32 alpha = 0;
+        for (u32 i = 0; i < 4; i++) {
+          // an odd edge row or column repeats into the block
+          const u32 sx = MATH_MIN(x * 2 + (i & 1), srcW - 1);
+          const u32 sy = MATH_MIN(y * 2 + (i >> 1), srcH - 1);
+          const u8* texel = &src[((u64)sy * srcW + sx) * 4];
+          const f32 a = texel[3] / 255.0f;
+          for (u32 c = 0; c < 3; c++) {
+            rgb[c] += toLinear[texel[c]] * a;
+          }
+          alpha += a;
+        }
+        u8* out = &dst[((u64)y * dstW + x) * 4];
+        for (u32 c = 0; c < 3; c++) {
+          const f32 linear = alpha > 0 ? rgb[c] / alpha : 0;
+          const f32 srgb =
+              linear <= 0.0031308f ? linear * 12.92f : 1.055f * powf(linear, 1 / 2.4f) - 0.055f;
+          out[c] = (u8)(MATH_CLAMP(0.0f, srgb, 1.0f) * 255.0f + 0.5f);
+        }
+        out[3] = (u8)(alpha / 4 * 255.0f + 0.5f);
+      }
+    }
+    src = dst;
+    dst += MipSize(width, height, level);
+  }
+
+  image->pixels = chain;
+  image->mipsCount = mipsCount;
+}
+
+static bool ReadCache(Loader__Image_t* image, const char* cacheFile, u64 sourceHash) {
+  if (!File__Map(&image->cache, cacheFile)) {
+    return false;
+  }
+  const Loader__CacheHeader_t* header = image->cache.data;
+  const u64 size = image->cache.size;
+  bool valid = size >= sizeof(Loader__CacheHeader_t) && LOADER_CACHE_MAGIC == header->magic &&
+               LOADER_CACHE_VERSION == header->version && sourceHash == header->sourceHash &&
+               LOADER_FORMAT_RGBA8 == header->format && header->mipsCount >= 1 &&
+               header->mipsCount <= LOADER_MIPS_CAP && header->mipOffsets[0] <= size;
+  // levels must be packed back-to-back, and lie within the file
+  u64 end = valid ? header->mipOffsets[0] : 0;
+  for (u32 level = 0; valid && level < header->mipsCount; level++) {
+    valid = end == header->mipOffsets[level] &&
+            MipSize(header->width, header->height, level) == header->mipSizes[level] &&
+            header->mipSizes[level] <= size - end;
+    end += header->mipSizes[level];
+  }
+  if (!valid) {
+    LOG_INFOF("texture cache is stale; source changed. file: %s", cacheFile)
+    File__Unmap(&image->cache);
+    return false;
+  }
+  image->pixels = (u8*)image->cache.data + header->mipOffsets[0];
+  image->width = header->width;
+  image->height = header->height;
+  image->mipsCount = header->mipsCount;
+  return true;
+}
+
+static void WriteCache(const Loader__Image_t* image, const char* cacheFile, u64 sourceHash) {
+  Loader__CacheHeader_t header;
+  memset(&header, 0, sizeof(header));
+  header.magic = LOADER_CACHE_MAGIC;
+  header.version = LOADER_CACHE_VERSION;
+  header.sourceHash = sourceHash;
+  header.format = LOADER_FORMAT_RGBA8;
+  header.width = image->width;
+  header.height = image->height;
+  header.mipsCount = image->mipsCount;
+  u64 offset = sizeof(header);
+  for (u32 level = 0; level < image->mipsCount; level++) {
+    header.mipOffsets[level] = offset;
+    header.mipSizes[level] = MipSize(image->width, image->height, level);
+    offset += header.mipSizes[level];
+  }
+
+  const void* datas[] = {&header, image->pixels};
+  const u64 sizes[] = {sizeof(header), offset - sizeof(header)};
+  if (File__WriteAll(cacheFile, ARRAY_COUNT(datas), datas, sizes)) {
+    LOG_INFOF("wrote texture cache. file: %s", cacheFile)
+  } else {
+    LOG_INFOF("failed to write texture cache. file: %s", cacheFile)
+  }
+}
+
+/**
+ * Load one image, on the calling thread. With useCache, a cache file matching the source is
+ * mapped instead of decoding, and a missing or stale one is rewritten.
+ * Returns false, with NULL pixels, if the source can't be read or decoded.
+ */
+bool Loader__Load(Loader__Image_t* image, bool useCache) {
+  image->pixels = NULL;
+  image->width = 0;
+  image->height = 0;
+  image->mipsCount = 0;
+  memset(&image->cache, 0, sizeof(File__Mapping_t));
+
+  File__Mapping_t source;
+  if (!File__Map(&source, image->file)) {
+    LOG_INFOF("failed to read image. file: %s", image->file)
+    return false;
+  }
+
+  char cacheFile[FILE_PATH_CAP];
+  u64 sourceHash = 0;
+  if (useCache) {
+    sourceHash = File__Hash(FILE_HASH_SEED, source.data, source.size);
+    Loader__CacheFile(image->file, cacheFile, sizeof(cacheFile));
+    if (ReadCache(image, cacheFile, sourceHash)) {
+      File__Unmap(&source);
+      return true;
+    }
+  }
+
+  int width, height, channels;
+  image->pixels = stbi_load_from_memory(
+      source.data,
+      (int)source.size,
+      &width,
+      &height,
+      &channels,
+      STBI_rgb_alpha);
+  File__Unmap(&source);
+  if (NULL == image->pixels) {
+    LOG_INFOF("failed to decode image. file: %s reason: %s", image->file, stbi_failure_reason())
+    return false;
+  }
+  image->width = width;
+  image->height = height;
+  GenerateMips(image);
+
+  if (useCache) {
+    WriteCache(image, cacheFile, sourceHash);
+  }
+  return true;
+}
+
+static void DecodeJob(void* data, u32 job) {
+  Loader__Image_t* image = &((Loader_t*)data)->m_images[job];
+  Loader__Load(image, true);
+  atomic_store_explicit(&image->decoded, true, memory_order_release);
+}
+
+static int LoaderMain(void* data) {
+  Loader_t* self = data;
+  while (true) {
+    SDL_SemWait(self->m_start);
+    if (self->m_quit) {
+      break;
+    }
+    // this thread is job thread 0; the pool's workers take the rest
+    Jobs__Run(&self->m_jobs, self->m_count, DecodeJob, self);
+    SDL_SemPost(self->m_idle);
+  }
+  return 0;
+}
+
+void Loader__New(Loader_t* self, u32 threadsCount) {
+  memset(self, 0, sizeof(Loader_t));
+  Jobs__New(&self->m_jobs, threadsCount);
+  self->m_start = SDL_CreateSemaphore(0);
+  ASSERT_CONTEXT(self->m_start, "SDL_CreateSemaphore failed. error: %s", SDL_GetError())
+  self->m_idle = SDL_CreateSemaphore(1);
+  ASSERT_CONTEXT(self->m_idle, "SDL_CreateSemaphore failed. error: %s", SDL_GetError())
+  self->m_thread = SDL_CreateThread(LoaderMain, "loader", self);
+  ASSERT_CONTEXT(self->m_thread, "SDL_CreateThread failed. error: %s", SDL_GetError())
+}
+
+/**
+ * Start decoding every image's file in the background. Returns without waiting,
+ * unless a previous batch is still decoding. images must outlive the batch.
+ */
+void Loader__Decode(Loader_t* self, u32 count, Loader__Image_t* images) {
+  SDL_SemWait(self->m_idle);
+  for (u32 i = 0; i < count; i++) {
+    images[i].pixels = NULL;
+    images[i].width = 0;
+    images[i].height = 0;
+    images[i].mipsCount = 0;
+    memset(&images[i].cache, 0, sizeof(File__Mapping_t));
+    atomic_init(&images[i].decoded, false);
+  }
+  self->m_count = count;
+  self->m_images = images;
+  SDL_SemPost(self->m_start);
+}
+
+bool Loader__IsDecoded(Loader__Image_t* image) {
+  return atomic_load_explicit(&image->decoded, memory_order_acquire);
+}
+
+void Loader__Free(Loader__Image_t* image) {
+  if (image->cache.data) {
+    File__Unmap(&image->cache);
+  } else {
+    free(image->pixels);
+  }
+  image->pixels = NULL;
+}
+
+void Loader__Shutdown(Loader_t* self) {
+  // let a running batch finish; its jobs still write into the images
+  SDL_SemWait(self->m_idle);
+  self->m_quit = true;
+  SDL_SemPost(self->m_start);
+  SDL_WaitThread(self->m_thread, NULL);
+  SDL_DestroySemaphore(self->m_start);
+  SDL_DestroySemaphore(self->m_idle);
+  Jobs__Shutdown(&self->m_jobs);
+  memset(self, 0, sizeof(Loader_t));
+}
@@ -0,0 +1,73 @@
+#ifndef LOADER_H
+#define LOADER_H
+
+// A loader decodes image files off the main thread
+// a background thread drives its own job pool, so a batch of files decodes in parallel,
+// one file per job, while the caller carries on and polls each image.
+// - pixels are RGBA8, as stbi_load() returns them
+// - one batch at a time; Loader__Decode() first waits for the previous batch
+// - a file which fails to decode is logged, and left with NULL pixels
+// - decoded pixels are cached beside the build output, keyed by a hash of the source file;
+//   a valid cache is memory-mapped, and its pixels are read straight from the mapping
+// - the full mip chain is generated when decoding, and cached with it; levels are packed
+//   back-to-back, largest first, each half the size of the last (rounded down, at least 1)
+
+#include <stdatomic.h>
+
+#include "Base.h"
+#include "File.h"
+#include "Jobs.h"
+
+#define LOADER_CACHE_MAGIC 0x43584554  // "TEXC"
+#define LOADER_CACHE_VERSION 2
+#define LOADER_CACHE_EXTENSION ".tex"
+#define LOADER_MIPS_CAP 16
+
+typedef enum {
+  LOADER_FORMAT_RGBA8,
+} Loader__Format_t;
+
+// a cache file starts with this header; the levels follow it, largest first
+typedef struct {
+  u32 magic;
+  u32 version;
+  u64 sourceHash;  // File__Hash() of the encoded source file
+  u32 format;
+  u32 width;
+  u32 height;
+  u32 mipsCount;
+  u64 mipOffsets[LOADER_MIPS_CAP];  // bytes, from the start of the file
+  u64 mipSizes[LOADER_MIPS_CAP];
+} Loader__CacheHeader_t;
+
+typedef struct {
+  const char* file;
+  u8* pixels;  // every level
+  u32 width;   // of level 0
+  u32 height;
+  u32 mipsCount;
+  File__Mapping_t cache;  // backs pixels, when they came from the cache
+  atomic_bool decoded;    // pixels, width and height may be read once set
+} Loader__Image_t;
+
+typedef struct {
+  Jobs_t m_jobs;
+  SDL_Thread* m_thread;
+  SDL_sem* m_start;
+  SDL_sem* m_idle;
+  bool m_quit;
+
+  // the batch being decoded
+  u32 m_count;
+  Loader__Image_t* m_images;
+} Loader_t;
+
+void Loader__New(Loader_t* self, u32 threadsCount);
+void Loader__CacheFile(const char* file, char* cacheFile, u32 cacheFileCap);
+bool Loader__Load(Loader__Image_t* image, bool useCache);
+void Loader__Decode(Loader_t* self, u32 count, Loader__Image_t* images);
+bool Loader__IsDecoded(Loader__Image_t* image);
+void Loader__Free(Loader__Image_t* image);
+void Loader__Shutdown(Loader_t* self);
+
+#endif
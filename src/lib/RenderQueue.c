@@ -0,0 +1,289 @@
+#include "RenderQueue.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define RADIX_BITS 8
+#define RADIX_BUCKETS (1 << RADIX_BITS)
+#define RADIX_PASSES (64 / RADIX_BITS)
+#define INSERTION_MAX 64           // keys; fewer new keys are insertion sorted instead
+#define INSERTION_MOVES_PER_KEY 4  // before a kept order is given up on, and radix sorted
+
+void RenderQueue__New(RenderQueue_t* self) {
+  memset(self, 0, sizeof(RenderQueue_t));
+}
+
+/**
+ * Pack a sort key. Fields wider than their bits are truncated.
+ * Depth sorts ascending, ie. the lowest depth is drawn first.
+ */
+u64 RenderQueue__Key(u32 layer, u32 pipeline, f32 depth, u32 texture) {
+  // flip floats so their unsigned order matches their numeric order; negatives count down
+  u32 bits;
+  memcpy(&bits, &depth, sizeof(u32));
+  bits ^= (bits >> 31) ? 0xffffffffu : 0x80000000u;
+
+  return (((u64)layer << RENDER_QUEUE_LAYER_SHIFT) & RENDER_QUEUE_LAYER_MASK) |
+         (((u64)pipeline << RENDER_QUEUE_PIPELINE_SHIFT) & RENDER_QUEUE_PIPELINE_MASK) |
+         ((u64)bits << RENDER_QUEUE_DEPTH_SHIFT) |
+         (((u64)texture << RENDER_QUEUE_TEXTURE_SHIFT) & RENDER_QUEUE_TEXTURE_MASK);
+}
+
+void RenderQueue__Clear(RenderQueue_t* self) {
+  self->m_count = 0;
+  self->m_sorted = 0;
+  self->m_drawsCount = 0;
+}
+
+void RenderQueue__Push(RenderQueue_t* self, u64 key, u32 id) {
+  if (self->m_count == self->m_cap) {
+    ASSERT_CONTEXT(self->m_cap <= UINT32_MAX / 2, "Too many queued. cap: %u", self->m_cap)
+    const u32 cap = MATH_MAX(self->m_cap * 2, RENDER_QUEUE_MIN_CAP);
+    u64* keys = realloc(self->m_keys, cap * sizeof(u64));
+    u32* ids = realloc(self->m_ids, cap * sizeof(u32));
+    u64* keysTmp = realloc(self->m_keysTmp, cap * sizeof(u64));
+    u32* idsTmp = realloc(self->m_idsTmp, cap * sizeof(u32));
+    ASSERT_CONTEXT(
+        keys && ids && keysTmp && idsTmp,
+        "Out of memory growing render queue. cap: %u",
+        cap)
+    self->m_keys = keys;
+    self->m_ids = ids;
+    self->m_keysTmp = keysTmp;
+    self->m_idsTmp = idsTmp;
+    self->m_cap = cap;
+  }
+  self->m_keys[self->m_count] = key;
+  self->m_ids[self->m_count] = id;
+  self->m_count++;
+}
+
+/**
+ * Start over from the last sort's order, rather than from empty. Each queued id takes its new key
+ * from keysById; those whose entry is RENDER_QUEUE_NONE leave the queue. The entries taken are
+ * reset to RENDER_QUEUE_NONE, so any left set are for ids not queued yet, to push next.
+ * keysById must cover every queued id. Returns the number kept.
+ */
+u32 RenderQueue__Retain(RenderQueue_t* self, u64* keysById) {
+  u32 kept = 0;
+  for (u32 i = 0; i < self->m_count; i++) {
+    const u32 id = self->m_ids[i];
+    const u64 key = keysById[id];
+    if (RENDER_QUEUE_NONE != key) {
+      keysById[id] = RENDER_QUEUE_NONE;
+      self->m_keys[kept] = key;
+      self->m_ids[kept] = id;
+      kept++;
+    }
+  }
+  self->m_count = kept;
+  self->m_sorted = kept;
+  self->m_drawsCount = 0;
+  return kept;
+}
+
+/**
+ * Re-key the entry at slot of a sorted queue, and move it to where it keeps the queue sorted;
+ * the entries in between shift one slot toward where it was. It goes after equal keys when it
+ * moves down, and before them when it moves up. Returns the entry's new slot.
+ */
+u32 RenderQueue__Rekey(RenderQueue_t* self, u32 slot, u64 key) {
+  const u32 id = self->m_ids[slot];
+  u32 to = slot;
+  while (to > 0 && self->m_keys[to - 1] > key) {
+    self->m_keys[to] = self->m_keys[to - 1];
+    self->m_ids[to] = self->m_ids[to - 1];
+    to--;
+  }
+  while (to + 1 < self->m_count && self->m_keys[to + 1] < key) {
+    self->m_keys[to] = self->m_keys[to + 1];
+    self->m_ids[to] = self->m_ids[to + 1];
+    to++;
+  }
+  self->m_keys[to] = key;
+  self->m_ids[to] = id;
+  self->m_drawsCount = 0;
+  return to;
+}
+
+/**
+ * Stable insertion sort; linear when the keys are already nearly in order.
+ * Gives up once more than maxMoves shifts were made, leaving the keys permuted but unsorted.
+ * Returns whether the keys are sorted.
+ */
+static bool InsertionSort(u64* keys, u32* ids, u32 count, u64 maxMoves) {
+  u64 moves = 0;
+  for (u32 i = 1; i < count; i++) {
+    const u64 key = keys[i];
+    if (keys[i - 1] <= key) {
+      continue;
+    }
+    const u32 id = ids[i];
+    u32 j = i;
+    while (j > 0 && keys[j - 1] > key) {
+      keys[j] = keys[j - 1];
+      ids[j] = ids[j - 1];
+      j--;
+    }
+    keys[j] = key;
+    ids[j] = id;
+    moves += i - j;
+    if (moves > maxMoves) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * Stable LSD radix sort. Every digit is counted in one read of the keys up front.
+ * Returns true when the result ended up in the tmp arrays, rather than the ones given.
+ */
+static bool RadixSort(u64* keys, u32* ids, u64* keysTmp, u32* idsTmp, u32 count) {
+  u32 histograms[RADIX_PASSES][RADIX_BUCKETS];
+  memset(histograms, 0, sizeof(histograms));
+  for (u32 i = 0; i < count; i++) {
+    const u64 key = keys[i];
+    for (u32 p = 0; p < RADIX_PASSES; p++) {
+      histograms[p][(key >> (p * RADIX_BITS)) & (RADIX_BUCKETS - 1)]++;
+    }
+  }
+
+  bool swapped = false;
+  for (u32 p = 0; p < RADIX_PASSES; p++) {
+    u32* offsets = histograms[p];
+    const u32 shift = p * RADIX_BITS;
+    if (count == offsets[(keys[0] >> shift) & (RADIX_BUCKETS - 1)]) {
+      continue;  // every key has this digit; the pass would move nothing
+    }
+
+    u32 offset = 0;
+    for (u32 b = 0; b < RADIX_BUCKETS; b++) {
+      const u32 n = offsets[b];
+      offsets[b] = offset;
+      offset += n;
+    }
+    for (u32 i = 0; i < count; i++) {
+      const u32 slot = offsets[(keys[i] >> shift) & (RADIX_BUCKETS - 1)]++;
+      keysTmp[slot] = keys[i];
+      idsTmp[slot] = ids[i];
+    }
+
+    u64* k = keys;
+    keys = keysTmp;
+    keysTmp = k;
+    u32* d = ids;
+    ids = idsTmp;
+    idsTmp = d;
+    swapped = !swapped;
+  }
+  return swapped;
+}
+
+static void SwapBuffers(RenderQueue_t* self) {
+  u64* keys = self->m_keys;
+  self->m_keys = self->m_keysTmp;
+  self->m_keysTmp = keys;
+  u32* ids = self->m_ids;
+  self->m_ids = self->m_idsTmp;
+  self->m_idsTmp = ids;
+}
+
+/**
+ * Sort the queue by key, ascending.
+ * Entries kept by RenderQueue__Retain() are insertion sorted, and those pushed since are sorted
+ * apart, then the two runs are merged.
+ */
+void RenderQueue__Sort(RenderQueue_t* self) {
+  const u32 count = self->m_count;
+  u32 kept = MATH_MIN(self->m_sorted, count);
+  self->m_sorted = count;
+  if (count < 2) {
+    return;
+  }
+
+  if (kept > 0 &&
+      !InsertionSort(self->m_keys, self->m_ids, kept, (u64)kept * INSERTION_MOVES_PER_KEY)) {
+    kept = 0;  // too much moved since; sort it all from scratch
+  }
+
+  const u32 pushed = count - kept;
+  u64* keys = self->m_keys + kept;
+  u32* ids = self->m_ids + kept;
+  if (pushed <= INSERTION_MAX) {
+    InsertionSort(keys, ids, pushed, UINT64_MAX);
+  } else if (RadixSort(keys, ids, self->m_keysTmp + kept, self->m_idsTmp + kept, pushed)) {
+    if (0 == kept) {
+      // adopt the buffer the last pass wrote, rather than copy back
+      SwapBuffers(self);
+      return;
+    }
+    memcpy(keys, self->m_keysTmp + kept, pushed * sizeof(u64));
+    memcpy(ids, self->m_idsTmp + kept, pushed * sizeof(u32));
+  }
+  if (0 == kept || 0 == pushed || self->m_keys[kept - 1] <= self->m_keys[kept]) {
+    return;  // a single run, or the pushed run already goes after
+  }
+
+  // merge the two runs; on equal keys, the kept one goes first
+  const u64* k = self->m_keys;
+  const u32* d = self->m_ids;
+  u32 a = 0;
+  u32 b = kept;
+  u32 o = 0;
+  while (a < kept && b < count) {
+    if (k[b] < k[a]) {
+      self->m_keysTmp[o] = k[b];
+      self->m_idsTmp[o++] = d[b++];
+    } else {
+      self->m_keysTmp[o] = k[a];
+      self->m_idsTmp[o++] = d[a++];
+    }
+  }
+  memcpy(&self->m_keysTmp[o], &k[a], (kept - a) * sizeof(u64));
+  memcpy(&self->m_idsTmp[o], &d[a], (kept - a) * sizeof(u32));
+  o += kept - a;
+  memcpy(&self->m_keysTmp[o], &k[b], (count - b) * sizeof(u64));
+  memcpy(&self->m_idsTmp[o], &d[b], (count - b) * sizeof(u32));
+  SwapBuffers(self);
+}
+
+/**
+ * Merge the sorted queue into the fewest draws; a draw ends wherever the key bits in breakMask
+ * change, ie. the state a draw binds. Draws index the queue, which is the order to upload in.
+ * Returns the number of draws.
+ */
+u32 RenderQueue__Merge(RenderQueue_t* self, u64 breakMask) {
+  self->m_drawsCount = 0;
+  u32 first = 0;
+  while (first < self->m_count) {
+    const u64 state = self->m_keys[first] & breakMask;
+    u32 end = first + 1;
+    while (end < self->m_count && state == (self->m_keys[end] & breakMask)) {
+      end++;
+    }
+
+    if (self->m_drawsCount == self->m_drawsCap) {
+      const u32 cap = MATH_MAX(self->m_drawsCap * 2, 16);
+      RenderQueue__Draw_t* draws = realloc(self->m_draws, cap * sizeof(RenderQueue__Draw_t));
+      ASSERT_CONTEXT(draws, "Out of memory growing render queue draws. cap: %u", cap)
+      self->m_draws = draws;
+      self->m_drawsCap = cap;
+    }
+    RenderQueue__Draw_t* draw = &self->m_draws[self->m_drawsCount++];
+    draw->firstInstance = first;
+    draw->instanceCount = end - first;
+    draw->state = state;
+    first = end;
+  }
+  return self->m_drawsCount;
+}
+
+void RenderQueue__Shutdown(RenderQueue_t* self) {
+  free(self->m_keys);
+  free(self->m_ids);
+  free(self->m_keysTmp);
+  free(self->m_idsTmp);
+  free(self->m_draws);
+  memset(self, 0, sizeof(RenderQueue_t));
+}
@@ -0,0 +1,67 @@
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+
+// A render queue orders one frame's visible instances by a 64-bit sort key
+// then merges neighbours which need no state change in between into instanced draws.
+// - key, from most to least significant: layer, pipeline, depth, texture
+//   depth ranks above texture; sprites blend back-to-front, and a bindless texture change
+//   doesn't split a draw, so the texture only groups sprites at equal depth
+// - sorted by an LSD radix sort, a byte per pass; passes where every key has the same byte are
+//   skipped, so keys using few distinct layers or pipelines cost fewer passes
+// - frame to frame, most keys barely change; RenderQueue__Retain() keeps the last order, re-keyed,
+//   which an insertion sort fixes up cheaply. keys pushed after are sorted on their own, then
+//   merged in. when too much moved, the insertion sort gives up and it all goes to the radix sort
+// - the sort is stable; instances with equal keys keep the order they were pushed or kept in,
+//   kept before pushed
+// - when only a few keys change in a sorted queue, RenderQueue__Rekey() moves each to its new
+//   place instead; the cost is the distance moved, not the queue's length
+// - only ids move; the instance data stays where it is
+
+#include "Base.h"
+
+#define RENDER_QUEUE_MIN_CAP 256
+
+#define RENDER_QUEUE_TEXTURE_SHIFT 0
+#define RENDER_QUEUE_DEPTH_SHIFT 16
+#define RENDER_QUEUE_PIPELINE_SHIFT 48
+#define RENDER_QUEUE_LAYER_SHIFT 56
+#define RENDER_QUEUE_TEXTURE_MASK (0xffffull << RENDER_QUEUE_TEXTURE_SHIFT)
+#define RENDER_QUEUE_DEPTH_MASK (0xffffffffull << RENDER_QUEUE_DEPTH_SHIFT)
+#define RENDER_QUEUE_PIPELINE_MASK (0xffull << RENDER_QUEUE_PIPELINE_SHIFT)
+#define RENDER_QUEUE_LAYER_MASK (0xffull << RENDER_QUEUE_LAYER_SHIFT)
+// never a key; Key() would only make it from layer 255, which is reserved
+#define RENDER_QUEUE_NONE UINT64_MAX
+
+// a run of the sorted queue, drawn with one call
+typedef struct {
+  u32 firstInstance;
+  u32 instanceCount;
+  u64 state;  // the key bits the run has in common; see RenderQueue__Merge()
+} RenderQueue__Draw_t;
+
+typedef struct {
+  u64* m_keys;
+  u32* m_ids;
+  u32 m_count;
+  u32 m_cap;
+  u32 m_sorted;  // leading entries in the order of the last sort, though maybe re-keyed since
+  // radix sort ping-pong; swapped with the above, so never read directly
+  u64* m_keysTmp;
+  u32* m_idsTmp;
+
+  RenderQueue__Draw_t* m_draws;
+  u32 m_drawsCount;
+  u32 m_drawsCap;
+} RenderQueue_t;
+
+void RenderQueue__New(RenderQueue_t* self);
+u64 RenderQueue__Key(u32 layer, u32 pipeline, f32 depth, u32 texture);
+void RenderQueue__Clear(RenderQueue_t* self);
+void RenderQueue__Push(RenderQueue_t* self, u64 key, u32 id);
+u32 RenderQueue__Retain(RenderQueue_t* self, u64* keysById);
+u32 RenderQueue__Rekey(RenderQueue_t* self, u32 slot, u64 key);
+void RenderQueue__Sort(RenderQueue_t* self);
+u32 RenderQueue__Merge(RenderQueue_t* self, u64 breakMask);
+void RenderQueue__Shutdown(RenderQueue_t* self);
+
+#endif
@@ -3,13 +3,18 @@
 #include <cglm/cglm.h>
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 #define VOLK_IMPLEMENTATION
 #include <volk.h>
 
 #include "Base.h"
+#include "File.h"
 #include "Shader.h"
+#include "Timer.h"
 
 void Vulkan__InitDriver1(Vulkan_t* self) {
   self->m_requiredDriverExtensionsCount = 0;
@@ -29,6 +34,27 @@ void Vulkan__InitDriver1(Vulkan_t* self) {
   self->m_framebufferResized = false;
   self->m_minimized = false;
   self->m_maximized = false;
+  self->m_headless = false;
+
+  self->m_framesInFlight = VULKAN_FRAMES_IN_FLIGHT_DEFAULT;
+  self->m_currentFrame = 0;
+
+  self->m_frameSerial = 1;
+  self->m_completedSerial = 0;
+  self->m_retiredHead = 0;
+  self->m_retiredCount = 0;
+
+  self->m_instanceSize = 0;
+
+  self->m_timestamps = false;
+  for (u8 i = 0; i < VULKAN_PASSES_COUNT; i++) {
+    self->m_passMs[i] = 0.0f;
+  }
+
+  self->m_textures = NULL;
+  self->m_texturesCap = 0;
+  self->m_texturesMax = 0;
+  self->m_textureInfos = NULL;
 
   self->m_SwapChain__formats_count = 0;
   self->m_SwapChain__presentModes_count = 0;
@@ -40,6 +66,9 @@ void Vulkan__InitDriver1(Vulkan_t* self) {
   self->m_SwapChain__queues.present_found = false;
   self->m_SwapChain__queues.present__index = 0;
   self->m_SwapChain__queues.present__queue = NULL;
+  self->m_SwapChain__queues.transfer_found = false;
+  self->m_SwapChain__queues.transfer__index = 0;
+  self->m_SwapChain__queues.transfer__queue = NULL;
 
   ASSERT(VK_SUCCESS == volkInitialize())
 }
@@ -225,11 +254,20 @@ void Vulkan__UsePhysicalDevice(Vulkan_t* self, const u8 requiredDeviceIndex) {
 static const char* specialPhysicalExtension1 = "VK_KHR_portability_subset";
 
 void Vulkan__AssertSwapChainSupported(Vulkan_t* self) {
+  // the bindless texture table; core since 1.2, listed so older devices fail here
   ASSERT(
-      self->m_requiredPhysicalDeviceExtensionsCount <=
+      self->m_requiredPhysicalDeviceExtensionsCount <
       VULKAN_REQUIRED_PHYSICAL_DEVICE_EXTENSIONS_CAP)
   self->m_requiredPhysicalDeviceExtensions[self->m_requiredPhysicalDeviceExtensionsCount++] =
-      VK_KHR_SWAPCHAIN_EXTENSION_NAME;
+      VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME;
+
+  if (!self->m_headless) {
+    ASSERT(
+        self->m_requiredPhysicalDeviceExtensionsCount <
+        VULKAN_REQUIRED_PHYSICAL_DEVICE_EXTENSIONS_CAP)
+    self->m_requiredPhysicalDeviceExtensions[self->m_requiredPhysicalDeviceExtensionsCount++] =
+        VK_KHR_SWAPCHAIN_EXTENSION_NAME;
+  }
 
   // list the extensions supported by this physical device
   u32 availablePhysicalExtensionCount = 0;
@@ -283,6 +321,11 @@ void Vulkan__AssertSwapChainSupported(Vulkan_t* self) {
         self->m_requiredPhysicalDeviceExtensions[i2])
   }
 
+  if (self->m_headless) {
+    // there is no surface to ask; offscreen images use the format a window would have
+    return;
+  }
+
   ASSERT(
       VK_SUCCESS == vkGetPhysicalDeviceSurfaceCapabilitiesKHR(
                         self->m_physicalDevice,
@@ -330,7 +373,7 @@ void Vulkan__CreateLogicalDeviceAndQueues(Vulkan_t* self) {
   ASSERT(VK_NULL_HANDLE != self->m_physicalDevice)
 
   // enumerate the queue families on current physical device
-  ASSERT(self->m_surface)
+  ASSERT(self->m_surface || self->m_headless)
 
   u32 queueFamilyCount = 0;
   vkGetPhysicalDeviceQueueFamilyProperties(self->m_physicalDevice, &queueFamilyCount, NULL);
@@ -356,14 +399,19 @@ void Vulkan__CreateLogicalDeviceAndQueues(Vulkan_t* self) {
 
     // Query if presentation is supported
     VkBool32 present = false;
-    ASSERT_CONTEXT(
-        VK_SUCCESS == vkGetPhysicalDeviceSurfaceSupportKHR(
-                          self->m_physicalDevice,
-                          i,
-                          self->m_surface,
-                          &present),
-        "queueFamilyIndex: %u",
-        i);
+    if (self->m_headless) {
+      // nothing is presented; the graphics family stands in
+      present = graphics;
+    } else {
+      ASSERT_CONTEXT(
+          VK_SUCCESS == vkGetPhysicalDeviceSurfaceSupportKHR(
+                            self->m_physicalDevice,
+                            i,
+                            self->m_surface,
+                            &present),
+          "queueFamilyIndex: %u",
+          i);
+    }
     // ASSERT_CONTEXT(present, "queue not present. queueFamilyIndex: %u", i);
 
     // strategy: select fewest family indices where required queues are present
@@ -386,6 +434,12 @@ void Vulkan__CreateLogicalDeviceAndQueues(Vulkan_t* self) {
       }
     }
 
+    // strategy: prefer a dedicated DMA family for uploads, so they overlap rendering
+    if (!self->m_SwapChain__queues.transfer_found && transfer && !graphics) {
+      self->m_SwapChain__queues.transfer_found = true;
+      self->m_SwapChain__queues.transfer__index = i;
+    }
+
     LOG_INFOF(
         "  %u: flags:%s%s%s%s%s%s%s",
         i,
@@ -418,31 +472,47 @@ void Vulkan__CreateLogicalDeviceAndQueues(Vulkan_t* self) {
         "will choose queue %u because it has PRESENT family",
         self->m_SwapChain__queues.present__index)
   }
+  if (self->m_SwapChain__queues.transfer_found) {
+    LOG_INFOF(
+        "will choose queue %u for uploads because it has a dedicated TRANSFER family",
+        self->m_SwapChain__queues.transfer__index)
+  } else {
+    self->m_SwapChain__queues.transfer__index = self->m_SwapChain__queues.graphics__index;
+    LOG_INFOF(
+        "will choose queue %u for uploads because no dedicated TRANSFER family exists",
+        self->m_SwapChain__queues.transfer__index)
+  }
 
   // for each unique queue family index,
   // construct a request for pointer to its VkQueue
   const float queuePriority = 1.0f;
-  u32 queueCreateInfosCount = self->m_SwapChain__queues.same ? 1 : 2;
-  VkDeviceQueueCreateInfo queueCreateInfos[queueCreateInfosCount];
-  {
-    VkDeviceQueueCreateInfo createInfo;
-    createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
-    createInfo.pNext = NULL;
-    createInfo.flags = 0;
-    createInfo.queueFamilyIndex = self->m_SwapChain__queues.graphics__index,
-    createInfo.queueCount = 1;
-    createInfo.pQueuePriorities = &queuePriority;
-    queueCreateInfos[0] = createInfo;
-  }
-  if (!self->m_SwapChain__queues.same) {
+  u32 families[] = {
+      self->m_SwapChain__queues.graphics__index,
+      self->m_SwapChain__queues.present__index,
+      self->m_SwapChain__queues.transfer__index,
+  };
+  u32 queueCreateInfosCount = 0;
+  VkDeviceQueueCreateInfo queueCreateInfos[ARRAY_COUNT(families)];
+  for (u8 i = 0; i < ARRAY_COUNT(families); i++) {
+    bool unique = true;
+    for (u8 i2 = 0; i2 < queueCreateInfosCount; i2++) {
+      if (queueCreateInfos[i2].queueFamilyIndex == families[i]) {
+        unique = false;
+        break;
+      }
+    }
+    if (!unique) {
+      continue;
+    }
+
     VkDeviceQueueCreateInfo createInfo;
     createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
     createInfo.pNext = NULL;
     createInfo.flags = 0;
-    createInfo.queueFamilyIndex = self->m_SwapChain__queues.present__index,
+    createInfo.queueFamilyIndex = families[i];
     createInfo.queueCount = 1;
     createInfo.pQueuePriorities = &queuePriority;
-    queueCreateInfos[2] = createInfo;
+    queueCreateInfos[queueCreateInfosCount++] = createInfo;
   }
 
   VkDeviceCreateInfo createInfo;
@@ -461,6 +531,52 @@ void Vulkan__CreateLogicalDeviceAndQueues(Vulkan_t* self) {
   createInfo.enabledExtensionCount = (u32)self->m_requiredPhysicalDeviceExtensionsCount;
   createInfo.ppEnabledExtensionNames = self->m_requiredPhysicalDeviceExtensions;
 
+  // the bindless texture table: a runtime-sized array, indexed per instance,
+  // partially written, sized per set, and refreshed while command buffers still bind it
+  VkPhysicalDeviceDescriptorIndexingFeatures indexingSupported;
+  memset(&indexingSupported, 0, sizeof(indexingSupported));
+  indexingSupported.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+  VkPhysicalDeviceFeatures2 supported;
+  memset(&supported, 0, sizeof(supported));
+  supported.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+  supported.pNext = &indexingSupported;
+  vkGetPhysicalDeviceFeatures2(self->m_physicalDevice, &supported);
+  ASSERT_CONTEXT(
+      indexingSupported.runtimeDescriptorArray &&
+          indexingSupported.shaderSampledImageArrayNonUniformIndexing &&
+          indexingSupported.descriptorBindingPartiallyBound &&
+          indexingSupported.descriptorBindingVariableDescriptorCount &&
+          indexingSupported.descriptorBindingSampledImageUpdateAfterBind,
+      "The device can't index a bindless texture array.")
+
+  VkPhysicalDeviceDescriptorIndexingFeatures indexing;
+  memset(&indexing, 0, sizeof(indexing));
+  indexing.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+  indexing.runtimeDescriptorArray = VK_TRUE;
+  indexing.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+  indexing.descriptorBindingPartiallyBound = VK_TRUE;
+  indexing.descriptorBindingVariableDescriptorCount = VK_TRUE;
+  indexing.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+  createInfo.pNext = &indexing;
+
+  // a combined image sampler counts against both the sampler and the sampled image limits
+  VkPhysicalDeviceDescriptorIndexingProperties indexingLimits;
+  memset(&indexingLimits, 0, sizeof(indexingLimits));
+  indexingLimits.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES;
+  VkPhysicalDeviceProperties2 properties;
+  memset(&properties, 0, sizeof(properties));
+  properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+  properties.pNext = &indexingLimits;
+  vkGetPhysicalDeviceProperties2(self->m_physicalDevice, &properties);
+  u32 texturesMax = VULKAN_TEXTURES_MAX;
+  texturesMax = MATH_MIN(texturesMax, indexingLimits.maxPerStageDescriptorUpdateAfterBindSamplers);
+  texturesMax =
+      MATH_MIN(texturesMax, indexingLimits.maxPerStageDescriptorUpdateAfterBindSampledImages);
+  texturesMax = MATH_MIN(texturesMax, indexingLimits.maxDescriptorSetUpdateAfterBindSamplers);
+  texturesMax = MATH_MIN(texturesMax, indexingLimits.maxDescriptorSetUpdateAfterBindSampledImages);
+  self->m_texturesMax = texturesMax;
+  LOG_INFOF("bindless texture table max: %u", self->m_texturesMax)
+
   VkPhysicalDeviceFeatures deviceFeatures;
   createInfo.pEnabledFeatures = &deviceFeatures;
   deviceFeatures.robustBufferAccess = VK_FALSE;
@@ -525,6 +641,8 @@ void Vulkan__CreateLogicalDeviceAndQueues(Vulkan_t* self) {
 
   LOG_INFOF("created logical device")
 
+  Allocator__New(&self->m_allocator, self->m_physicalDevice, self->m_logicalDevice);
+
   vkGetDeviceQueue(
       self->m_logicalDevice,
       self->m_SwapChain__queues.graphics__index,
@@ -538,9 +656,51 @@ void Vulkan__CreateLogicalDeviceAndQueues(Vulkan_t* self) {
         0,
         &self->m_SwapChain__queues.present__queue);
   }
+
+  vkGetDeviceQueue(
+      self->m_logicalDevice,
+      self->m_SwapChain__queues.transfer__index,
+      0,
+      &self->m_SwapChain__queues.transfer__queue);
+}
+
+/**
+ * Stand-in for the swapchain when headless: a ring of offscreen color images.
+ */
+static void CreateOffscreenImages(Vulkan_t* self) {
+  self->m_SwapChain__images_count = VULKAN_DESIRED_SWAPCHAIN_IMAGES_COUNT;
+  self->m_SwapChain__imageFormat = VK_FORMAT_B8G8R8A8_SRGB;
+  self->m_SwapChain__extent.width = self->m_bufferWidth;
+  self->m_SwapChain__extent.height = self->m_bufferHeight;
+
+  for (u8 i = 0; i < self->m_SwapChain__images_count; i++) {
+    Vulkan__CreateImage(
+        self,
+        self->m_bufferWidth,
+        self->m_bufferHeight,
+        1,
+        self->m_SwapChain__imageFormat,
+        VK_IMAGE_TILING_OPTIMAL,
+        VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        &self->m_SwapChain__images[i],
+        &self->m_SwapChain__imageAllocations[i]);
+  }
+  self->m_imageIndex = 0;
+
+  LOG_INFOF(
+      "offscreen images created. width %u height %u imageCount %u",
+      self->m_bufferWidth,
+      self->m_bufferHeight,
+      self->m_SwapChain__images_count);
 }
 
 void Vulkan__CreateSwapChain(Vulkan_t* self, bool hadPriorSwapChain) {
+  if (self->m_headless) {
+    CreateOffscreenImages(self);
+    return;
+  }
+
   bool found1 = false;
   VkSurfaceFormatKHR format;
 
@@ -571,9 +731,16 @@ void Vulkan__CreateSwapChain(Vulkan_t* self, bool hadPriorSwapChain) {
     mode = VK_PRESENT_MODE_FIFO_KHR;
   }
 
+  // the window may have moved on since the resize event; stay within what the surface allows
   VkExtent2D extent;
-  extent.width = self->m_bufferWidth;
-  extent.height = self->m_bufferHeight;
+  extent.width = MATH_CLAMP(
+      self->m_SwapChain__capabilities.minImageExtent.width,
+      self->m_bufferWidth,
+      self->m_SwapChain__capabilities.maxImageExtent.width);
+  extent.height = MATH_CLAMP(
+      self->m_SwapChain__capabilities.minImageExtent.height,
+      self->m_bufferHeight,
+      self->m_SwapChain__capabilities.maxImageExtent.height);
 
   self->m_SwapChain__images_count = MATH_MIN(
       VULKAN_DESIRED_SWAPCHAIN_IMAGES_COUNT,
@@ -610,7 +777,8 @@ void Vulkan__CreateSwapChain(Vulkan_t* self, bool hadPriorSwapChain) {
   createInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
   createInfo.presentMode = mode;
   createInfo.clipped = VK_TRUE;
-  createInfo.oldSwapchain = NULL;  // hadPriorSwapChain ? self->m_swapChain : NULL;
+  // lets the driver reuse the old swapchain's resources, while frames in flight finish with it
+  createInfo.oldSwapchain = hadPriorSwapChain ? self->m_swapChain : VK_NULL_HANDLE;
 
   ASSERT(
       VK_SUCCESS ==
@@ -673,7 +841,30 @@ void Vulkan__CreateImageViews(Vulkan_t* self) {
   }
 }
 
+/**
+ * The first depth format the device can attach; 16-bit depth is always supported.
+ */
+static VkFormat PickDepthFormat(Vulkan_t* self) {
+  const VkFormat candidates[] = {
+      VK_FORMAT_D32_SFLOAT,
+      VK_FORMAT_X8_D24_UNORM_PACK32,
+      VK_FORMAT_D16_UNORM,
+  };
+  for (u8 i = 0; i < ARRAY_COUNT(candidates); i++) {
+    VkFormatProperties properties;
+    vkGetPhysicalDeviceFormatProperties(self->m_physicalDevice, candidates[i], &properties);
+    if (properties.optimalTilingFeatures & VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT) {
+      return candidates[i];
+    }
+  }
+  ASSERT_CONTEXT(false, "No depth attachment format is supported.")
+  return VK_FORMAT_UNDEFINED;
+}
+
 void Vulkan__CreateRenderPass(Vulkan_t* self) {
+  self->m_depthFormat = PickDepthFormat(self);
+
+  VkAttachmentDescription attachments[2];
   VkAttachmentDescription colorAttachment;
   {
     VkAttachmentDescriptionFlags flags = VK_ATTACHMENT_DESCRIPTION_MAY_ALIAS_BIT;
@@ -686,13 +877,36 @@ void Vulkan__CreateRenderPass(Vulkan_t* self) {
     colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
     colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
     colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    // headless frames are read back instead of presented
+    colorAttachment.finalLayout = self->m_headless ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL
+                                                   : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+  }
+
+  attachments[0] = colorAttachment;
+
+  // only read within the pass; never stored
+  VkAttachmentDescription depthAttachment;
+  {
+    depthAttachment.flags = 0;
+    depthAttachment.format = self->m_depthFormat;
+    depthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+    depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
   }
+  attachments[1] = depthAttachment;
 
   VkAttachmentReference colorAttachmentRef[1];
   colorAttachmentRef[0].attachment = 0;
   colorAttachmentRef[0].layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 
+  VkAttachmentReference depthAttachmentRef;
+  depthAttachmentRef.attachment = 1;
+  depthAttachmentRef.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
   VkSubpassDescription subpass;
   {
     subpass.flags = 0;
@@ -702,7 +916,7 @@ void Vulkan__CreateRenderPass(Vulkan_t* self) {
     subpass.colorAttachmentCount = 1;
     subpass.pColorAttachments = colorAttachmentRef;
     subpass.pResolveAttachments = NULL;
-    subpass.pDepthStencilAttachment = NULL;
+    subpass.pDepthStencilAttachment = &depthAttachmentRef;
     subpass.preserveAttachmentCount = 0;
     subpass.pPreserveAttachments = NULL;
   }
@@ -710,10 +924,16 @@ void Vulkan__CreateRenderPass(Vulkan_t* self) {
   VkSubpassDependency dependency;
   dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
   dependency.dstSubpass = 0;
-  dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-  dependency.srcAccessMask = 0;
-  dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-  dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+  dependency.srcStageMask =
+      VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+  // without an acquire semaphore, order against the image's previous frame directly.
+  // the depth attachment is shared, so the previous frame's depth writes always need ordering
+  dependency.srcAccessMask = (self->m_headless ? VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT : 0) |
+                             VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+  dependency.dstStageMask =
+      VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+  dependency.dstAccessMask =
+      VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
   dependency.dependencyFlags = 0;
 
   VkRenderPassCreateInfo renderPassInfo;
@@ -721,8 +941,8 @@ void Vulkan__CreateRenderPass(Vulkan_t* self) {
   renderPassInfo.pNext = NULL;
   VkRenderPassCreateFlags flags = VK_RENDER_PASS_CREATE_TRANSFORM_BIT_QCOM;
   renderPassInfo.flags = flags;
-  renderPassInfo.attachmentCount = 1;
-  renderPassInfo.pAttachments = &colorAttachment;
+  renderPassInfo.attachmentCount = ARRAY_COUNT(attachments);
+  renderPassInfo.pAttachments = attachments;
   renderPassInfo.subpassCount = 1;
   renderPassInfo.pSubpasses = &subpass;
   renderPassInfo.dependencyCount = 1;
@@ -734,11 +954,24 @@ void Vulkan__CreateRenderPass(Vulkan_t* self) {
 }
 
 void Vulkan__CreateDescriptorSetLayout(Vulkan_t* self) {
+  // the texture array is sized per set, when allocated; a variable count must be the last binding
+  VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlags;
+  bindingFlags.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+  bindingFlags.pNext = NULL;
+  bindingFlags.bindingCount = 3;
+  bindingFlags.pBindingFlags = (VkDescriptorBindingFlags[]){
+      0,
+      0,
+      VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT |
+          VK_DESCRIPTOR_BINDING_VARIABLE_DESCRIPTOR_COUNT_BIT |
+          VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT,
+  };
+
   VkDescriptorSetLayoutCreateInfo layoutInfo;
   layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-  layoutInfo.pNext = NULL;
-  layoutInfo.flags = 0;
-  layoutInfo.bindingCount = 2;
+  layoutInfo.pNext = &bindingFlags;
+  layoutInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+  layoutInfo.bindingCount = 3;
   layoutInfo.pBindings = (VkDescriptorSetLayoutBinding[]){
       {
           .binding = 0,
@@ -750,6 +983,13 @@ void Vulkan__CreateDescriptorSetLayout(Vulkan_t* self) {
       {
           .binding = 1,
           .descriptorCount = 1,
+          .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+          .pImmutableSamplers = NULL,
+          .stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
+      },
+      {
+          .binding = 2,
+          .descriptorCount = self->m_texturesMax,
           .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
           .pImmutableSamplers = NULL,
           .stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT,
@@ -779,6 +1019,113 @@ void Vulkan__DestroyShaderModule(Vulkan_t* self, const VkShaderModule* shaderMod
   vkDestroyShaderModule(self->m_logicalDevice, *shaderModule, NULL);
 }
 
+static void FillPipelineCacheHeader(Vulkan_t* self, Vulkan__PipelineCacheHeader_t* header) {
+  VkPhysicalDeviceProperties properties;
+  vkGetPhysicalDeviceProperties(self->m_physicalDevice, &properties);
+
+  memset(header, 0, sizeof(Vulkan__PipelineCacheHeader_t));
+  header->magic = VULKAN_PIPELINE_CACHE_MAGIC;
+  header->headerSize = sizeof(Vulkan__PipelineCacheHeader_t);
+  header->vendorID = properties.vendorID;
+  header->deviceID = properties.deviceID;
+  header->driverVersion = properties.driverVersion;
+  memcpy(header->pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE);
+  header->shaderHash = self->m_pipelineCacheShaderHash;
+}
+
+/**
+ * Create the pipeline cache, seeded from file when it was written by this device,
+ * driver and set of shaders. Otherwise starts empty (cold).
+ */
+void Vulkan__LoadPipelineCache(
+    Vulkan_t* self, const char* file, u32 shaderFilesCount, const char* shaderFiles[]) {
+  const u64 start = Now();
+  self->m_pipelineCacheFile = file;
+  self->m_pipelineCacheWarm = false;
+
+  // any shader change invalidates the whole file
+  self->m_pipelineCacheShaderHash = FILE_HASH_SEED;
+  for (u32 i = 0; i < shaderFilesCount; i++) {
+    char shader[VULKAN_SHADER_FILE_BUFFER_BYTES_CAP];
+    u64 len = Shader__ReadFile(shader, shaderFiles[i]);
+    self->m_pipelineCacheShaderHash = File__Hash(self->m_pipelineCacheShaderHash, shader, len);
+  }
+
+  Vulkan__PipelineCacheHeader_t expected;
+  FillPipelineCacheHeader(self, &expected);
+
+  void* data = NULL;
+  u64 dataSize = 0;
+  FILE* fh;
+  if (0 == fopen_s(&fh, file, "rb") && NULL != fh) {
+    Vulkan__PipelineCacheHeader_t header;
+    if (1 == fread(&header, sizeof(header), 1, fh) &&
+        0 == memcmp(&header, &expected, offsetof(Vulkan__PipelineCacheHeader_t, dataSize)) &&
+        header.dataSize <= VULKAN_PIPELINE_CACHE_DATA_CAP) {
+      data = malloc(header.dataSize);
+      ASSERT(data)
+      if (header.dataSize == fread(data, 1, header.dataSize, fh)) {
+        dataSize = header.dataSize;
+        self->m_pipelineCacheWarm = true;
+      }
+    } else {
+      LOG_INFOF("pipeline cache is stale; device, driver, or shaders changed. file: %s", file)
+    }
+    fclose(fh);
+  }
+
+  VkPipelineCacheCreateInfo createInfo;
+  createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+  createInfo.pNext = NULL;
+  createInfo.flags = 0;
+  createInfo.initialDataSize = dataSize;
+  createInfo.pInitialData = data;
+
+  ASSERT(
+      VK_SUCCESS ==
+      vkCreatePipelineCache(self->m_logicalDevice, &createInfo, NULL, &self->m_pipelineCache))
+  free(data);
+
+  LOG_INFOF(
+      "loaded %s pipeline cache. bytes: %llu, ms: %.3f",
+      self->m_pipelineCacheWarm ? "warm" : "cold",
+      (unsigned long long)dataSize,
+      (f64)(Now() - start) / CYCLES_PER_MILLISECOND)
+}
+
+void Vulkan__SavePipelineCache(Vulkan_t* self) {
+  if (!self->m_pipelineCache || NULL == self->m_pipelineCacheFile) {
+    return;
+  }
+
+  size_t dataSize = 0;
+  ASSERT(
+      VK_SUCCESS ==
+      vkGetPipelineCacheData(self->m_logicalDevice, self->m_pipelineCache, &dataSize, NULL))
+  void* data = malloc(dataSize);
+  ASSERT(data)
+  ASSERT(
+      VK_SUCCESS ==
+      vkGetPipelineCacheData(self->m_logicalDevice, self->m_pipelineCache, &dataSize, data))
+
+  Vulkan__PipelineCacheHeader_t header;
+  FillPipelineCacheHeader(self, &header);
+  header.dataSize = dataSize;
+
+  // a crash mid-save leaves the old cache, or none; never a truncated one
+  const void* datas[] = {&header, data};
+  const u64 sizes[] = {sizeof(header), dataSize};
+  if (File__WriteAll(self->m_pipelineCacheFile, ARRAY_COUNT(datas), datas, sizes)) {
+    LOG_INFOF(
+        "saved pipeline cache. bytes: %llu, file: %s",
+        (unsigned long long)dataSize,
+        self->m_pipelineCacheFile)
+  } else {
+    LOG_INFOF("failed to save pipeline cache. file: %s", self->m_pipelineCacheFile)
+  }
+  free(data);
+}
+
 void Vulkan__CreateGraphicsPipeline(
     Vulkan_t* self,
     const char* frag_shader,
@@ -790,6 +1137,9 @@ void Vulkan__CreateGraphicsPipeline(
     u32 locations[],
     u32 formats[],
     u32 offsets[]) {
+  self->m_instanceSize = instanceSize;
+
+  const u64 start = Now();
   const char shader1[VULKAN_SHADER_FILE_BUFFER_BYTES_CAP];
   u64 len1 = Shader__ReadFile((char*)&shader1, frag_shader);
   const char shader2[VULKAN_SHADER_FILE_BUFFER_BYTES_CAP];
@@ -912,31 +1262,68 @@ void Vulkan__CreateGraphicsPipeline(
   multisampling.alphaToCoverageEnable = VK_FALSE;
   multisampling.alphaToOneEnable = VK_FALSE;
 
-  // TODO: configure the depth and stencil tests using VkPipelineDepthStencilStateCreateInfo
-
-  VkPipelineColorBlendAttachmentState colorBlendAttachment;
-  colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT |
-                                        VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
-  colorBlendAttachment.blendEnable = VK_TRUE;
-  colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
-  colorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
-  colorBlendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
-  colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
-  colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
-  colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
-
-  VkPipelineColorBlendStateCreateInfo colorBlending;
-  colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
-  colorBlending.pNext = NULL;
-  colorBlending.flags = 0;
-  colorBlending.logicOpEnable = VK_FALSE;
-  colorBlending.logicOp = VK_LOGIC_OP_COPY;
-  colorBlending.attachmentCount = 1;
-  colorBlending.pAttachments = &colorBlendAttachment;
-  colorBlending.blendConstants[0] = 1.0f;
-  colorBlending.blendConstants[1] = 1.0f;
-  colorBlending.blendConstants[2] = 1.0f;
-  colorBlending.blendConstants[3] = 1.0f;
+  // per Vulkan__Pipeline_t: the opaque pipeline writes depth, so it must not blend;
+  // instead, its fragment shader discards what would have (constant_id 0)
+  const VkBool32 alphaTests[VULKAN_PIPELINES_COUNT] = {VK_TRUE, VK_FALSE};
+  VkSpecializationMapEntry alphaTestEntry;
+  alphaTestEntry.constantID = 0;
+  alphaTestEntry.offset = 0;
+  alphaTestEntry.size = sizeof(VkBool32);
+
+  VkPipelineShaderStageCreateInfo pipelineStages[VULKAN_PIPELINES_COUNT][2];
+  VkSpecializationInfo specializations[VULKAN_PIPELINES_COUNT];
+  VkPipelineDepthStencilStateCreateInfo depthStencils[VULKAN_PIPELINES_COUNT];
+  VkPipelineColorBlendAttachmentState colorBlendAttachments[VULKAN_PIPELINES_COUNT];
+  VkPipelineColorBlendStateCreateInfo colorBlendings[VULKAN_PIPELINES_COUNT];
+  for (u8 p = 0; p < VULKAN_PIPELINES_COUNT; p++) {
+    const bool opaque = VULKAN_PIPELINE_OPAQUE == p;
+
+    specializations[p].mapEntryCount = 1;
+    specializations[p].pMapEntries = &alphaTestEntry;
+    specializations[p].dataSize = sizeof(VkBool32);
+    specializations[p].pData = &alphaTests[p];
+    pipelineStages[p][0] = shaderStages[0];
+    pipelineStages[p][1] = shaderStages[1];
+    pipelineStages[p][1].pSpecializationInfo = &specializations[p];
+
+    // equal depths pass, so sprites at one depth still draw over each other in order
+    VkPipelineDepthStencilStateCreateInfo* depthStencil = &depthStencils[p];
+    memset(depthStencil, 0, sizeof(VkPipelineDepthStencilStateCreateInfo));
+    depthStencil->sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+    depthStencil->pNext = NULL;
+    depthStencil->flags = 0;
+    depthStencil->depthTestEnable = VK_TRUE;
+    depthStencil->depthWriteEnable = opaque ? VK_TRUE : VK_FALSE;
+    depthStencil->depthCompareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
+    depthStencil->depthBoundsTestEnable = VK_FALSE;
+    depthStencil->stencilTestEnable = VK_FALSE;
+    depthStencil->minDepthBounds = 0.0f;
+    depthStencil->maxDepthBounds = 1.0f;
+
+    VkPipelineColorBlendAttachmentState* colorBlendAttachment = &colorBlendAttachments[p];
+    colorBlendAttachment->colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT |
+                                           VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+    colorBlendAttachment->blendEnable = opaque ? VK_FALSE : VK_TRUE;
+    colorBlendAttachment->srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+    colorBlendAttachment->dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+    colorBlendAttachment->colorBlendOp = VK_BLEND_OP_ADD;
+    colorBlendAttachment->srcAlphaBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+    colorBlendAttachment->dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+    colorBlendAttachment->alphaBlendOp = VK_BLEND_OP_ADD;
+
+    VkPipelineColorBlendStateCreateInfo* colorBlending = &colorBlendings[p];
+    colorBlending->sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+    colorBlending->pNext = NULL;
+    colorBlending->flags = 0;
+    colorBlending->logicOpEnable = VK_FALSE;
+    colorBlending->logicOp = VK_LOGIC_OP_COPY;
+    colorBlending->attachmentCount = 1;
+    colorBlending->pAttachments = colorBlendAttachment;
+    colorBlending->blendConstants[0] = 1.0f;
+    colorBlending->blendConstants[1] = 1.0f;
+    colorBlending->blendConstants[2] = 1.0f;
+    colorBlending->blendConstants[3] = 1.0f;
+  }
 
   VkPipelineLayoutCreateInfo pipelineLayoutInfo;
   pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
@@ -952,50 +1339,85 @@ void Vulkan__CreateGraphicsPipeline(
                         NULL,
                         &self->m_pipelineLayout))
 
-  VkGraphicsPipelineCreateInfo pipelineInfo;
-  pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-  pipelineInfo.pNext = NULL;
-  pipelineInfo.flags = 0;
-  pipelineInfo.stageCount = 2;
-  pipelineInfo.pStages = shaderStages;
-  pipelineInfo.pVertexInputState = &vertexInputInfo;
-  pipelineInfo.pInputAssemblyState = &inputAssembly;
-  pipelineInfo.pViewportState = &viewportState;
-  pipelineInfo.pRasterizationState = &rasterizer;
-  pipelineInfo.pMultisampleState = &multisampling;
-  pipelineInfo.pDepthStencilState = NULL;
-  pipelineInfo.pColorBlendState = &colorBlending;
-  pipelineInfo.pDynamicState = &dynamicState;
-  pipelineInfo.layout = self->m_pipelineLayout;
-  pipelineInfo.renderPass = self->m_renderPass;
-  pipelineInfo.subpass = 0;
-  pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
-  pipelineInfo.basePipelineIndex = -1;
+  VkGraphicsPipelineCreateInfo pipelineInfos[VULKAN_PIPELINES_COUNT];
+  for (u8 p = 0; p < VULKAN_PIPELINES_COUNT; p++) {
+    VkGraphicsPipelineCreateInfo* pipelineInfo = &pipelineInfos[p];
+    pipelineInfo->sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+    pipelineInfo->pNext = NULL;
+    pipelineInfo->flags = 0;
+    pipelineInfo->stageCount = 2;
+    pipelineInfo->pStages = pipelineStages[p];
+    pipelineInfo->pVertexInputState = &vertexInputInfo;
+    pipelineInfo->pInputAssemblyState = &inputAssembly;
+    pipelineInfo->pViewportState = &viewportState;
+    pipelineInfo->pRasterizationState = &rasterizer;
+    pipelineInfo->pMultisampleState = &multisampling;
+    pipelineInfo->pDepthStencilState = &depthStencils[p];
+    pipelineInfo->pColorBlendState = &colorBlendings[p];
+    pipelineInfo->pDynamicState = &dynamicState;
+    pipelineInfo->layout = self->m_pipelineLayout;
+    pipelineInfo->renderPass = self->m_renderPass;
+    pipelineInfo->subpass = 0;
+    pipelineInfo->basePipelineHandle = VK_NULL_HANDLE;
+    pipelineInfo->basePipelineIndex = -1;
+  }
 
   ASSERT(
       VK_SUCCESS == vkCreateGraphicsPipelines(
                         self->m_logicalDevice,
-                        VK_NULL_HANDLE,
-                        1,
-                        &pipelineInfo,
+                        self->m_pipelineCache,
+                        VULKAN_PIPELINES_COUNT,
+                        pipelineInfos,
                         NULL,
-                        &self->m_graphicsPipeline))
+                        self->m_graphicsPipelines))
+  Vulkan__InvalidateDrawCommands(self, VULKAN_DIRTY_PIPELINE);
 
   Vulkan__DestroyShaderModule(self, &vertShaderModule);
   Vulkan__DestroyShaderModule(self, &fragShaderModule);
+
+  LOG_INFOF(
+      "created graphics pipeline. cache: %s, ms: %.3f",
+      !self->m_pipelineCache ? "none" : self->m_pipelineCacheWarm ? "warm" : "cold",
+      (f64)(Now() - start) / CYCLES_PER_MILLISECOND)
+}
+
+/**
+ * One depth image, sized to the swapchain, is shared by every framebuffer.
+ * Its contents are cleared at the start and dropped at the end of each frame, so
+ * frames in flight never read each other's depth.
+ */
+static void CreateDepthImage(Vulkan_t* self) {
+  Vulkan__CreateImage(
+      self,
+      self->m_SwapChain__extent.width,
+      self->m_SwapChain__extent.height,
+      1,
+      self->m_depthFormat,
+      VK_IMAGE_TILING_OPTIMAL,
+      VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
+      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+      &self->m_depthImage,
+      &self->m_depthImageAllocation);
+  Vulkan__CreateImageView(
+      self,
+      &self->m_depthImage,
+      self->m_depthFormat,
+      VK_IMAGE_ASPECT_DEPTH_BIT,
+      1,
+      &self->m_depthImageView);
 }
 
 void Vulkan__CreateFrameBuffers(Vulkan_t* self) {
+  CreateDepthImage(self);
   for (size_t i = 0; i < self->m_SwapChain__images_count; i++) {
-    VkImageView attachments[] = {self->m_SwapChain__imageViews[i]};
+    VkImageView attachments[] = {self->m_SwapChain__imageViews[i], self->m_depthImageView};
 
     VkFramebufferCreateInfo framebufferInfo;
     framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
     framebufferInfo.pNext = NULL;
     framebufferInfo.flags = 0;
     framebufferInfo.renderPass = self->m_renderPass;
-    // TODO: couldn't/shouldn't we have one framebuffer, with two attachments?
-    framebufferInfo.attachmentCount = 1;
+    framebufferInfo.attachmentCount = ARRAY_COUNT(attachments);
     framebufferInfo.pAttachments = attachments;
     framebufferInfo.width = self->m_SwapChain__extent.width;
     framebufferInfo.height = self->m_SwapChain__extent.height;
@@ -1023,17 +1445,7 @@ void Vulkan__CreateCommandPool(Vulkan_t* self) {
 }
 
 u32 Vulkan__FindMemoryType(Vulkan_t* self, u32 typeFilter, VkMemoryPropertyFlags properties) {
-  VkPhysicalDeviceMemoryProperties memProperties;
-  vkGetPhysicalDeviceMemoryProperties(self->m_physicalDevice, &memProperties);
-
-  for (u32 i = 0; i < memProperties.memoryTypeCount; i++) {
-    if ((typeFilter & (1 << i)) &&
-        (memProperties.memoryTypes[i].propertyFlags & properties) == properties) {
-      return i;
-    }
-  }
-
-  ASSERT_CONTEXT(false, "failed to find suitable memory type!");
+  return Allocator__FindMemoryType(&self->m_allocator, typeFilter, properties);
 }
 
 void Vulkan__CreateBuffer(
@@ -1042,45 +1454,63 @@ void Vulkan__CreateBuffer(
     VkBufferUsageFlags usage,
     VkMemoryPropertyFlags properties,
     VkBuffer* buffer,
-    VkDeviceMemory* bufferMemory) {
+    Allocation_t* allocation) {
   VkBufferCreateInfo bufferInfo;
   bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
   bufferInfo.pNext = NULL;
   bufferInfo.flags = 0;
   bufferInfo.size = size;
   bufferInfo.usage = usage;
-  bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+  // with a dedicated transfer family, share instead of transferring queue ownership
+  const u32 families[] = {
+      self->m_SwapChain__queues.graphics__index,
+      self->m_SwapChain__queues.transfer__index,
+  };
+  if (self->m_SwapChain__queues.transfer_found) {
+    bufferInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+    bufferInfo.queueFamilyIndexCount = 2;
+    bufferInfo.pQueueFamilyIndices = families;
+  } else {
+    bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    bufferInfo.queueFamilyIndexCount = 0;
+    bufferInfo.pQueueFamilyIndices = NULL;
+  }
 
   ASSERT(VK_SUCCESS == vkCreateBuffer(self->m_logicalDevice, &bufferInfo, NULL, buffer))
 
   VkMemoryRequirements memRequirements;
   vkGetBufferMemoryRequirements(self->m_logicalDevice, *buffer, &memRequirements);
 
-  VkMemoryAllocateInfo allocInfo;
-  allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-  allocInfo.pNext = NULL;
-  allocInfo.allocationSize = memRequirements.size;
-  allocInfo.memoryTypeIndex =
-      Vulkan__FindMemoryType(self, memRequirements.memoryTypeBits, properties);
+  // sub-allocated, so we stay well under maxMemoryAllocationCount
+  Allocator__Alloc(&self->m_allocator, &memRequirements, properties, true, allocation);
 
-  // TODO: The maximum number of simultaneous memory allocations is limited by the
-  // maxMemoryAllocationCount So when objects on screen become too numerous, create a custom
-  // allocator
-  ASSERT(VK_SUCCESS == vkAllocateMemory(self->m_logicalDevice, &allocInfo, NULL, bufferMemory))
+  ASSERT(
+      VK_SUCCESS == vkBindBufferMemory(
+                        self->m_logicalDevice,
+                        *buffer,
+                        allocation->memory,
+                        allocation->offset))
+}
 
-  vkBindBufferMemory(self->m_logicalDevice, *buffer, *bufferMemory, 0);
+void Vulkan__DestroyBuffer(Vulkan_t* self, VkBuffer* buffer, Allocation_t* allocation) {
+  if (*buffer) {
+    vkDestroyBuffer(self->m_logicalDevice, *buffer, NULL);
+    *buffer = VK_NULL_HANDLE;
+  }
+  Allocator__Free(&self->m_allocator, allocation);
 }
 
 void Vulkan__CreateImage(
     Vulkan_t* self,
     uint32_t width,
     uint32_t height,
+    u32 mipLevels,
     VkFormat format,
     VkImageTiling tiling,
     VkImageUsageFlags usage,
     VkMemoryPropertyFlags properties,
     VkImage* image,
-    VkDeviceMemory* imageMemory) {
+    Allocation_t* allocation) {
   VkImageCreateInfo imageInfo;
   imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
   imageInfo.pNext = NULL;
@@ -1089,41 +1519,127 @@ void Vulkan__CreateImage(
   imageInfo.extent.width = width;
   imageInfo.extent.height = height;
   imageInfo.extent.depth = 1;
-  imageInfo.mipLevels = 1;
+  imageInfo.mipLevels = mipLevels;
   imageInfo.arrayLayers = 1;
   imageInfo.format = format;
   imageInfo.tiling = tiling;
   imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
   imageInfo.usage = usage;
   imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
-  imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+  const u32 families[] = {
+      self->m_SwapChain__queues.graphics__index,
+      self->m_SwapChain__queues.transfer__index,
+  };
+  if (self->m_SwapChain__queues.transfer_found) {
+    imageInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+    imageInfo.queueFamilyIndexCount = 2;
+    imageInfo.pQueueFamilyIndices = families;
+  } else {
+    imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    imageInfo.queueFamilyIndexCount = 0;
+    imageInfo.pQueueFamilyIndices = NULL;
+  }
 
   ASSERT(VK_SUCCESS == vkCreateImage(self->m_logicalDevice, &imageInfo, NULL, image))
 
   VkMemoryRequirements memRequirements;
   vkGetImageMemoryRequirements(self->m_logicalDevice, *image, &memRequirements);
 
-  VkMemoryAllocateInfo allocInfo;
-  allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-  allocInfo.pNext = NULL;
-  allocInfo.allocationSize = memRequirements.size;
-  allocInfo.memoryTypeIndex =
-      Vulkan__FindMemoryType(self, memRequirements.memoryTypeBits, properties);
+  Allocator__Alloc(
+      &self->m_allocator,
+      &memRequirements,
+      properties,
+      VK_IMAGE_TILING_LINEAR == tiling,
+      allocation);
+
+  ASSERT(
+      VK_SUCCESS == vkBindImageMemory(
+                        self->m_logicalDevice,
+                        *image,
+                        allocation->memory,
+                        allocation->offset))
+}
+
+void Vulkan__DestroyImage(Vulkan_t* self, VkImage* image, Allocation_t* allocation) {
+  if (*image) {
+    vkDestroyImage(self->m_logicalDevice, *image, NULL);
+    *image = VK_NULL_HANDLE;
+  }
+  Allocator__Free(&self->m_allocator, allocation);
+}
+
+void Vulkan__CreateUploader(Vulkan_t* self) {
+  VkCommandPoolCreateInfo poolInfo;
+  poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+  poolInfo.pNext = NULL;
+  poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT |
+                   VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+  poolInfo.queueFamilyIndex = self->m_SwapChain__queues.transfer__index;
+
+  ASSERT(
+      VK_SUCCESS ==
+      vkCreateCommandPool(self->m_logicalDevice, &poolInfo, NULL, &self->m_uploadCommandPool))
+
+  VkSemaphoreCreateInfo semaphoreInfo;
+  semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+  semaphoreInfo.pNext = NULL;
+  semaphoreInfo.flags = 0;
+
+  VkFenceCreateInfo fenceInfo;
+  fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+  fenceInfo.pNext = NULL;
+  fenceInfo.flags = 0;
+
+  for (u8 i = 0; i < VULKAN_UPLOAD_BATCHES_CAP; i++) {
+    Vulkan__UploadBatch_t* batch = &self->m_uploadBatches[i];
 
-  ASSERT(VK_SUCCESS == vkAllocateMemory(self->m_logicalDevice, &allocInfo, NULL, imageMemory))
+    VkCommandBufferAllocateInfo allocInfo;
+    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.pNext = NULL;
+    allocInfo.commandPool = self->m_uploadCommandPool;
+    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.commandBufferCount = 1;
+
+    ASSERT(
+        VK_SUCCESS ==
+        vkAllocateCommandBuffers(self->m_logicalDevice, &allocInfo, &batch->commandBuffer))
+    ASSERT(
+        VK_SUCCESS ==
+        vkCreateSemaphore(self->m_logicalDevice, &semaphoreInfo, NULL, &batch->semaphore))
+    ASSERT(VK_SUCCESS == vkCreateFence(self->m_logicalDevice, &fenceInfo, NULL, &batch->fence))
+
+    batch->ticket = 0;
+    batch->recording = false;
+    batch->submitted = false;
+    batch->waitPending = false;
+    batch->stagingCount = 0;
+  }
 
-  vkBindImageMemory(self->m_logicalDevice, *image, *imageMemory, 0);
+  self->m_uploadBatch = 0;
+  self->m_uploadTicketNext = 1;
+  self->m_uploadTicketCompleted = 0;
 }
 
-void Vulkan__BeginSingleTimeCommands(Vulkan_t* self, VkCommandBuffer* commandBuffer) {
-  VkCommandBufferAllocateInfo allocInfo;
-  allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-  allocInfo.pNext = NULL;
-  allocInfo.commandPool = self->m_commandPool;
-  allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-  allocInfo.commandBufferCount = 1;
+/**
+ * Returns the open upload batch's command buffer, beginning a batch if needed.
+ * NOTICE: call after Vulkan__UploadStaging(), which may submit the open batch when it fills.
+ */
+VkCommandBuffer Vulkan__BeginUpload(Vulkan_t* self) {
+  Vulkan__UploadBatch_t* batch = &self->m_uploadBatches[self->m_uploadBatch];
+  if (batch->recording) {
+    return batch->commandBuffer;
+  }
+
+  if (batch->submitted) {
+    // every batch is in flight; apply back-pressure
+    Vulkan__AwaitUpload(self, batch->ticket);
+  }
+  if (batch->waitPending) {
+    // no frame has consumed its semaphore yet; it can't be signaled again until waited
+    Vulkan__FlushUploadWaits(self);
+  }
 
-  ASSERT(VK_SUCCESS == vkAllocateCommandBuffers(self->m_logicalDevice, &allocInfo, commandBuffer));
+  ASSERT(VK_SUCCESS == vkResetCommandBuffer(batch->commandBuffer, 0))
 
   VkCommandBufferBeginInfo beginInfo;
   beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
@@ -1131,11 +1647,50 @@ void Vulkan__BeginSingleTimeCommands(Vulkan_t* self, VkCommandBuffer* commandBuf
   beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
   beginInfo.pInheritanceInfo = NULL;
 
-  ASSERT(VK_SUCCESS == vkBeginCommandBuffer(*commandBuffer, &beginInfo))
+  ASSERT(VK_SUCCESS == vkBeginCommandBuffer(batch->commandBuffer, &beginInfo))
+
+  batch->recording = true;
+  batch->ticket = self->m_uploadTicketNext++;
+  return batch->commandBuffer;
+}
+
+/**
+ * Allocate a host-visible staging buffer owned by the open upload batch.
+ * It is released once the batch completes. Returns the mapped pointer to write to.
+ */
+void* Vulkan__UploadStaging(Vulkan_t* self, VkDeviceSize size, VkBuffer* buffer) {
+  Vulkan__BeginUpload(self);
+  Vulkan__UploadBatch_t* batch = &self->m_uploadBatches[self->m_uploadBatch];
+  if (batch->stagingCount >= VULKAN_UPLOAD_STAGING_CAP) {
+    Vulkan__SubmitUploads(self);
+    Vulkan__BeginUpload(self);
+    batch = &self->m_uploadBatches[self->m_uploadBatch];
+  }
+
+  const u32 i = batch->stagingCount++;
+  Vulkan__CreateBuffer(
+      self,
+      size,
+      VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+      &batch->stagingBuffers[i],
+      &batch->stagingAllocations[i]);
+
+  *buffer = batch->stagingBuffers[i];
+  return batch->stagingAllocations[i].mapped;
 }
 
-void Vulkan__EndSingleTimeCommands(Vulkan_t* self, VkCommandBuffer* commandBuffer) {
-  vkEndCommandBuffer(*commandBuffer);
+/**
+ * Submit the open upload batch, if any, without waiting on it.
+ * Returns a ticket covering everything submitted so far.
+ */
+Vulkan__UploadTicket_t Vulkan__SubmitUploads(Vulkan_t* self) {
+  Vulkan__UploadBatch_t* batch = &self->m_uploadBatches[self->m_uploadBatch];
+  if (!batch->recording) {
+    return self->m_uploadTicketNext - 1;
+  }
+
+  ASSERT(VK_SUCCESS == vkEndCommandBuffer(batch->commandBuffer))
 
   VkSubmitInfo submitInfo[] = {
       {
@@ -1145,28 +1700,116 @@ void Vulkan__EndSingleTimeCommands(Vulkan_t* self, VkCommandBuffer* commandBuffe
           .pWaitSemaphores = VK_NULL_HANDLE,
           .pWaitDstStageMask = 0,
           .commandBufferCount = 1,
-          .pCommandBuffers = commandBuffer,
+          .pCommandBuffers = &batch->commandBuffer,
+          .signalSemaphoreCount = 1,
+          .pSignalSemaphores = &batch->semaphore,
+      },
+  };
+
+  ASSERT(
+      VK_SUCCESS ==
+      vkQueueSubmit(self->m_SwapChain__queues.transfer__queue, 1, submitInfo, batch->fence))
+
+  batch->recording = false;
+  batch->submitted = true;
+  batch->waitPending = true;
+  self->m_uploadBatch = (self->m_uploadBatch + 1) % VULKAN_UPLOAD_BATCHES_CAP;
+  return batch->ticket;
+}
+
+bool Vulkan__IsUploadComplete(Vulkan_t* self, Vulkan__UploadTicket_t ticket) {
+  if (ticket > self->m_uploadTicketCompleted) {
+    Vulkan__CollectUploads(self);
+  }
+  return ticket <= self->m_uploadTicketCompleted;
+}
+
+void Vulkan__AwaitUpload(Vulkan_t* self, Vulkan__UploadTicket_t ticket) {
+  if (ticket <= self->m_uploadTicketCompleted) {
+    return;
+  }
+  for (u8 i = 0; i < VULKAN_UPLOAD_BATCHES_CAP; i++) {
+    Vulkan__UploadBatch_t* batch = &self->m_uploadBatches[i];
+    if (batch->ticket < ticket || !(batch->recording || batch->submitted)) {
+      continue;
+    }
+    if (batch->recording) {
+      Vulkan__SubmitUploads(self);
+    }
+    ASSERT(
+        VK_SUCCESS ==
+        vkWaitForFences(self->m_logicalDevice, 1, &batch->fence, VK_TRUE, UINT64_MAX))
+    break;
+  }
+  Vulkan__CollectUploads(self);
+}
+
+/**
+ * Retire completed upload batches, releasing their staging buffers.
+ * Batches execute in submission order on one queue, so tickets complete in order.
+ */
+void Vulkan__CollectUploads(Vulkan_t* self) {
+  for (u8 i = 0; i < VULKAN_UPLOAD_BATCHES_CAP; i++) {
+    Vulkan__UploadBatch_t* batch = &self->m_uploadBatches[i];
+    if (!batch->submitted || VK_SUCCESS != vkGetFenceStatus(self->m_logicalDevice, batch->fence)) {
+      continue;
+    }
+
+    ASSERT(VK_SUCCESS == vkResetFences(self->m_logicalDevice, 1, &batch->fence))
+    for (u32 i2 = 0; i2 < batch->stagingCount; i2++) {
+      Vulkan__DestroyBuffer(self, &batch->stagingBuffers[i2], &batch->stagingAllocations[i2]);
+    }
+    batch->stagingCount = 0;
+    batch->submitted = false;
+    self->m_uploadTicketCompleted = MATH_MAX(self->m_uploadTicketCompleted, batch->ticket);
+  }
+}
+
+/**
+ * Consume upload semaphores that no frame has waited on yet, with an empty graphics submit.
+ */
+void Vulkan__FlushUploadWaits(Vulkan_t* self) {
+  u32 waitCount = 0;
+  VkSemaphore waitSemaphores[VULKAN_UPLOAD_BATCHES_CAP];
+  VkPipelineStageFlags waitStages[VULKAN_UPLOAD_BATCHES_CAP];
+  for (u8 i = 0; i < VULKAN_UPLOAD_BATCHES_CAP; i++) {
+    if (self->m_uploadBatches[i].waitPending) {
+      self->m_uploadBatches[i].waitPending = false;
+      waitSemaphores[waitCount] = self->m_uploadBatches[i].semaphore;
+      waitStages[waitCount] = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+      waitCount++;
+    }
+  }
+  if (0 == waitCount) {
+    return;
+  }
+
+  VkSubmitInfo submitInfo[] = {
+      {
+          .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+          .pNext = NULL,
+          .waitSemaphoreCount = waitCount,
+          .pWaitSemaphores = waitSemaphores,
+          .pWaitDstStageMask = waitStages,
+          .commandBufferCount = 0,
+          .pCommandBuffers = NULL,
           .signalSemaphoreCount = 0,
           .pSignalSemaphores = VK_NULL_HANDLE,
       },
   };
-
   ASSERT(
       VK_SUCCESS ==
       vkQueueSubmit(self->m_SwapChain__queues.graphics__queue, 1, submitInfo, VK_NULL_HANDLE))
-  ASSERT(VK_SUCCESS == vkQueueWaitIdle(self->m_SwapChain__queues.graphics__queue))
-
-  vkFreeCommandBuffers(self->m_logicalDevice, self->m_commandPool, 1, commandBuffer);
 }
 
 void Vulkan__TransitionImageLayout(
     Vulkan_t* self,
     VkImage* image,
     VkFormat format,
+    u32 mipLevels,
     VkImageLayout oldLayout,
     VkImageLayout newLayout) {
-  VkCommandBuffer commandBuffer;
-  Vulkan__BeginSingleTimeCommands(self, &commandBuffer);
+  VkCommandBuffer commandBuffer = Vulkan__BeginUpload(self);
 
   VkImageMemoryBarrier barrier[] = {{
       .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
@@ -1178,7 +1821,7 @@ void Vulkan__TransitionImageLayout(
       .image = *image,
       .subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
       .subresourceRange.baseMipLevel = 0,
-      .subresourceRange.levelCount = 1,
+      .subresourceRange.levelCount = mipLevels,
       .subresourceRange.baseArrayLayer = 0,
       .subresourceRange.layerCount = 1,
   }};
@@ -1195,11 +1838,13 @@ void Vulkan__TransitionImageLayout(
   } else if (
       oldLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL &&
       newLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) {
+    // this may run on a transfer-only queue, which has no fragment stage;
+    // visibility to shaders comes from the semaphore the graphics queue waits on
     barrier[0].srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-    barrier[0].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    barrier[0].dstAccessMask = 0;
 
     sourceStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-    destinationStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+    destinationStage = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
   } else {
     ASSERT_CONTEXT(false, "unsupported layout transition!")
   }
@@ -1215,21 +1860,24 @@ void Vulkan__TransitionImageLayout(
       NULL,
       1,
       barrier);
-
-  Vulkan__EndSingleTimeCommands(self, &commandBuffer);
 }
 
 void Vulkan__CopyBufferToImage(
-    Vulkan_t* self, VkBuffer* buffer, VkImage* image, u32 width, u32 height) {
-  VkCommandBuffer commandBuffer;
-  Vulkan__BeginSingleTimeCommands(self, &commandBuffer);
+    Vulkan_t* self,
+    VkBuffer* buffer,
+    VkDeviceSize offset,
+    VkImage* image,
+    u32 mipLevel,
+    u32 width,
+    u32 height) {
+  VkCommandBuffer commandBuffer = Vulkan__BeginUpload(self);
 
   VkBufferImageCopy region;
-  region.bufferOffset = 0;
+  region.bufferOffset = offset;
   region.bufferRowLength = 0;
   region.bufferImageHeight = 0;
   region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-  region.imageSubresource.mipLevel = 0;
+  region.imageSubresource.mipLevel = mipLevel;
   region.imageSubresource.baseArrayLayer = 0;
   region.imageSubresource.layerCount = 1;
   region.imageOffset = (VkOffset3D){0, 0, 0};
@@ -1242,73 +1890,227 @@ void Vulkan__CopyBufferToImage(
       VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
       1,
       &region);
-
-  Vulkan__EndSingleTimeCommands(self, &commandBuffer);
 }
 
 /**
- * Load an image from disk. Queue it to Vulkan -> Buffer -> Image.
+ * Queue an RGBA8 image to Vulkan -> Buffer -> Image, with a view, without waiting on the upload.
+ * pixels holds every level, tightly packed, largest first; each level halves, down to 1.
  */
-void Vulkan__CreateTextureImage(Vulkan_t* self, const char* file) {
-  int texWidth, texHeight, texChannels;
-  stbi_uc* pixels = stbi_load(file, &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
-  VkDeviceSize imageSize = texWidth * texHeight * 4;
-
-  ASSERT_CONTEXT(pixels, "failed to load texture image!")
+static void UploadTextureImage(
+    Vulkan_t* self,
+    Vulkan__Texture_t* texture,
+    u32 width,
+    u32 height,
+    u32 mipsCount,
+    const void* pixels) {
+  ASSERT_CONTEXT(
+      mipsCount >= 1 && mipsCount <= VULKAN_TEXTURE_MIPS_CAP,
+      "Invalid mip count. mipsCount: %u",
+      mipsCount)
+  VkDeviceSize imageSize = 0;
+  for (u32 level = 0; level < mipsCount; level++) {
+    imageSize += (VkDeviceSize)MATH_MAX(width >> level, 1) * MATH_MAX(height >> level, 1) * 4;
+  }
 
   VkBuffer stagingBuffer;
-  VkDeviceMemory stagingBufferMemory;
-  Vulkan__CreateBuffer(
-      self,
-      imageSize,
-      VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-      &stagingBuffer,
-      &stagingBufferMemory);
-
-  void* data;
-  vkMapMemory(self->m_logicalDevice, stagingBufferMemory, 0, imageSize, 0, &data);
+  void* data = Vulkan__UploadStaging(self, imageSize, &stagingBuffer);
   memcpy(data, pixels, (size_t)(imageSize));
-  vkUnmapMemory(self->m_logicalDevice, stagingBufferMemory);
-
-  stbi_image_free(pixels);
 
   Vulkan__CreateImage(
       self,
-      texWidth,
-      texHeight,
+      width,
+      height,
+      mipsCount,
       VK_FORMAT_R8G8B8A8_SRGB,
       VK_IMAGE_TILING_OPTIMAL,
       VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
       VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-      &self->m_textureImage,
-      &self->m_textureImageMemory);
+      &texture->image,
+      &texture->allocation);
 
   Vulkan__TransitionImageLayout(
       self,
-      &self->m_textureImage,
+      &texture->image,
       VK_FORMAT_R8G8B8A8_SRGB,
+      mipsCount,
       VK_IMAGE_LAYOUT_UNDEFINED,
       VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-  Vulkan__CopyBufferToImage(
-      self,
-      &stagingBuffer,
-      &self->m_textureImage,
-      (u32)(texWidth),
-      (u32)(texHeight));
+  VkDeviceSize offset = 0;
+  for (u32 level = 0; level < mipsCount; level++) {
+    const u32 levelWidth = MATH_MAX(width >> level, 1);
+    const u32 levelHeight = MATH_MAX(height >> level, 1);
+    Vulkan__CopyBufferToImage(
+        self,
+        &stagingBuffer,
+        offset,
+        &texture->image,
+        level,
+        levelWidth,
+        levelHeight);
+    offset += (VkDeviceSize)levelWidth * levelHeight * 4;
+  }
   Vulkan__TransitionImageLayout(
       self,
-      &self->m_textureImage,
+      &texture->image,
       VK_FORMAT_R8G8B8A8_SRGB,
+      mipsCount,
       VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
       VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
 
-  vkDestroyBuffer(self->m_logicalDevice, stagingBuffer, NULL);
-  vkFreeMemory(self->m_logicalDevice, stagingBufferMemory, NULL);
+  Vulkan__CreateImageView(
+      self,
+      &texture->image,
+      VK_FORMAT_R8G8B8A8_SRGB,
+      VK_IMAGE_ASPECT_COLOR_BIT,
+      mipsCount,
+      &texture->imageView);
+
+  texture->width = width;
+  texture->height = height;
+  texture->mipsCount = mipsCount;
+  // every command above went into the open batch
+  texture->ticket = self->m_uploadBatches[self->m_uploadBatch].ticket;
+  texture->resident = false;
+}
+
+/**
+ * A 1x1 transparent texture, bound in place of any texture that isn't resident yet.
+ * It is part of the initial uploads, which the first frame waits on.
+ */
+void Vulkan__CreatePlaceholderTexture(Vulkan_t* self) {
+  const u8 pixel[4] = {0, 0, 0, 0};
+  UploadTextureImage(self, &self->m_placeholderTexture, 1, 1, 1, pixel);
+  self->m_placeholderTexture.used = true;
+  self->m_placeholderTexture.resident = true;
+}
+
+/**
+ * Double the texture table. Once the descriptor sets exist, they are reallocated to match,
+ * from a new pool; frames still in flight keep the old one until they complete.
+ */
+static void GrowTextures(Vulkan_t* self) {
+  const u32 cap = MATH_MIN(
+      MATH_MAX(self->m_texturesCap * 2, VULKAN_TEXTURES_MIN_CAP),
+      self->m_texturesMax);
+  ASSERT_CONTEXT(cap > self->m_texturesCap, "Out of texture slots. max: %u", self->m_texturesMax)
+
+  Vulkan__Texture_t* textures = realloc(self->m_textures, cap * sizeof(Vulkan__Texture_t));
+  ASSERT_CONTEXT(textures, "Out of memory growing textures. cap: %u", cap)
+  memset(
+      &textures[self->m_texturesCap],
+      0,
+      (cap - self->m_texturesCap) * sizeof(Vulkan__Texture_t));
+  VkDescriptorImageInfo* infos =
+      realloc(self->m_textureInfos, cap * sizeof(VkDescriptorImageInfo));
+  ASSERT_CONTEXT(infos, "Out of memory growing texture descriptors. cap: %u", cap)
+
+  LOG_DEBUGF("grew texture table from %u to %u", self->m_texturesCap, cap)
+  self->m_textures = textures;
+  self->m_textureInfos = infos;
+  self->m_texturesCap = cap;
+
+  if (self->m_descriptorPool) {
+    Vulkan__RetireDescriptorPool(self, &self->m_descriptorPool);
+    Vulkan__CreateDescriptorPool(self);
+    Vulkan__CreateDescriptorSets(self);
+  }
+}
+
+/**
+ * Returns a handle to a new texture, which samples as the placeholder until uploaded.
+ * The handle is also the texture's index in the bindless array, which instances select by.
+ */
+u32 Vulkan__NewTexture(Vulkan_t* self, Vulkan__TextureFilter_t filter) {
+  u32 i = 0;
+  while (i < self->m_texturesCap && self->m_textures[i].used) {
+    i++;
+  }
+  if (i == self->m_texturesCap) {
+    GrowTextures(self);
+  }
+
+  Vulkan__Texture_t* texture = &self->m_textures[i];
+  memset(texture, 0, sizeof(Vulkan__Texture_t));
+  texture->used = true;
+  texture->filter = filter;
+  // its element may never have been written; the placeholder goes there until it is resident
+  for (u8 f = 0; f < self->m_framesInFlight; f++) {
+    self->m_frames[f].textureDescriptorsStale = true;
+  }
+  return i;
+}
+
+/**
+ * Queue decoded RGBA8 pixels for a texture. The pixels are copied; the caller may free them.
+ * Replacing a texture's contents retires its old image; the placeholder is bound in between.
+ */
+void Vulkan__UploadTexture(
+    Vulkan_t* self, u32 texture, u32 width, u32 height, u32 mipsCount, const void* pixels) {
+  Vulkan__Texture_t* t = &self->m_textures[texture];
+  ASSERT_CONTEXT(t->used, "Texture not created. texture: %u", texture)
+  if (t->image) {
+    Vulkan__RetireImageView(self, &t->imageView);
+    Vulkan__RetireImage(self, &t->image, &t->allocation);
+    if (t->resident) {
+      for (u8 i = 0; i < self->m_framesInFlight; i++) {
+        self->m_frames[i].textureDescriptorsStale = true;
+      }
+    }
+  }
+  UploadTextureImage(self, t, width, height, mipsCount, pixels);
+}
+
+bool Vulkan__IsTextureResident(Vulkan_t* self, u32 texture) {
+  return self->m_textures[texture].resident;
+}
+
+/**
+ * Promote textures whose uploads have completed, so the next frames bind them.
+ */
+void Vulkan__CollectTextures(Vulkan_t* self) {
+  bool promoted = false;
+  for (u32 i = 0; i < self->m_texturesCap; i++) {
+    Vulkan__Texture_t* texture = &self->m_textures[i];
+    if (texture->used && texture->image && !texture->resident &&
+        texture->ticket <= self->m_uploadTicketCompleted) {
+      texture->resident = true;
+      promoted = true;
+      LOG_DEBUGF(
+          "texture resident. texture: %u width %u height %u mips %u",
+          i,
+          texture->width,
+          texture->height,
+          texture->mipsCount)
+    }
+  }
+  if (promoted) {
+    for (u8 i = 0; i < self->m_framesInFlight; i++) {
+      self->m_frames[i].textureDescriptorsStale = true;
+    }
+  }
+}
+
+/**
+ * Free a texture's handle. Frames still in flight may sample it, so its image is retired.
+ * Its array element is left as is; the array is partially bound, and nothing samples it anymore.
+ */
+void Vulkan__DestroyTexture(Vulkan_t* self, u32 texture) {
+  Vulkan__Texture_t* t = &self->m_textures[texture];
+  if (t->image) {
+    Vulkan__RetireImageView(self, &t->imageView);
+    Vulkan__RetireImage(self, &t->image, &t->allocation);
+  }
+  t->used = false;
+  t->resident = false;
 }
 
 void Vulkan__CreateImageView(
-    Vulkan_t* self, VkImage* image, VkFormat format, VkImageView* imageView) {
+    Vulkan_t* self,
+    VkImage* image,
+    VkFormat format,
+    VkImageAspectFlags aspect,
+    u32 mipLevels,
+    VkImageView* imageView) {
   VkImageViewCreateInfo viewInfo;
   viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
   viewInfo.pNext = NULL;
@@ -1320,140 +2122,803 @@ void Vulkan__CreateImageView(
   viewInfo.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
   viewInfo.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
   viewInfo.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
-  viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+  viewInfo.subresourceRange.aspectMask = aspect;
   viewInfo.subresourceRange.baseMipLevel = 0;
-  viewInfo.subresourceRange.levelCount = 1;
+  viewInfo.subresourceRange.levelCount = mipLevels;
   viewInfo.subresourceRange.baseArrayLayer = 0;
   viewInfo.subresourceRange.layerCount = 1;
 
   ASSERT(VK_SUCCESS == vkCreateImageView(self->m_logicalDevice, &viewInfo, NULL, imageView))
 }
 
-void Vulkan__CreateTextureImageView(Vulkan_t* self) {
-  Vulkan__CreateImageView(
-      self,
-      &self->m_textureImage,
-      VK_FORMAT_R8G8B8A8_SRGB,
-      &self->m_textureImageView);
-}
-
-void Vulkan__CreateTextureSampler(Vulkan_t* self) {
+/**
+ * One sampler per Vulkan__TextureFilter_t. Each samples every level of the texture bound with it;
+ * the view limits the levels, so LOD is not clamped here.
+ */
+void Vulkan__CreateTextureSamplers(Vulkan_t* self) {
   VkPhysicalDeviceProperties properties;
   vkGetPhysicalDeviceProperties(self->m_physicalDevice, &properties);
 
-  VkSamplerCreateInfo samplerInfo;
-  samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
-  samplerInfo.pNext = NULL;
-  samplerInfo.flags = 0;
-  // nearest is best for pixel art, but a pixel shader is even better
-  samplerInfo.magFilter = VK_FILTER_NEAREST;                // VK_FILTER_LINEAR;
-  samplerInfo.minFilter = VK_FILTER_NEAREST;                // VK_FILTER_LINEAR;
-  samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;  // VK_SAMPLER_MIPMAP_MODE_LINEAR;
-  samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-  samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-  samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-  samplerInfo.mipLodBias = 0;
-  samplerInfo.anisotropyEnable = VK_TRUE;
-  samplerInfo.maxAnisotropy = properties.limits.maxSamplerAnisotropy;
-  samplerInfo.compareEnable = VK_FALSE;
-  samplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
-  samplerInfo.minLod = 0;
-  samplerInfo.maxLod = 0;
-  samplerInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
-  samplerInfo.unnormalizedCoordinates = VK_FALSE;
+  for (u8 filter = 0; filter < VULKAN_TEXTURE_FILTERS_COUNT; filter++) {
+    const bool pixelArt = VULKAN_TEXTURE_FILTER_PIXEL_ART == filter;
+
+    VkSamplerCreateInfo samplerInfo;
+    samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    samplerInfo.pNext = NULL;
+    samplerInfo.flags = 0;
+    // nearest is best for pixel art, but a pixel shader is even better.
+    // zoomed out, levels are still blended, so minified sprites don't shimmer or pop
+    samplerInfo.magFilter = pixelArt ? VK_FILTER_NEAREST : VK_FILTER_LINEAR;
+    samplerInfo.minFilter = pixelArt ? VK_FILTER_NEAREST : VK_FILTER_LINEAR;
+    samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+    samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    samplerInfo.mipLodBias = 0;
+    samplerInfo.anisotropyEnable = VK_TRUE;
+    samplerInfo.maxAnisotropy = properties.limits.maxSamplerAnisotropy;
+    samplerInfo.compareEnable = VK_FALSE;
+    samplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
+    samplerInfo.minLod = 0;
+    samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
+    samplerInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
+    samplerInfo.unnormalizedCoordinates = VK_FALSE;
 
-  ASSERT(
-      VK_SUCCESS ==
-      vkCreateSampler(self->m_logicalDevice, &samplerInfo, NULL, &self->m_textureSampler))
+    ASSERT(
+        VK_SUCCESS == vkCreateSampler(
+                          self->m_logicalDevice,
+                          &samplerInfo,
+                          NULL,
+                          &self->m_textureSamplers[filter]))
+  }
 }
 
 void Vulkan__CopyBuffer(
     Vulkan_t* self, VkBuffer* srcBuffer, VkBuffer* dstBuffer, VkDeviceSize size) {
-  VkCommandBuffer commandBuffer;
-  Vulkan__BeginSingleTimeCommands(self, &commandBuffer);
+  VkCommandBuffer commandBuffer = Vulkan__BeginUpload(self);
 
   VkBufferCopy copyRegion;
   copyRegion.srcOffset = 0;
   copyRegion.dstOffset = 0;
   copyRegion.size = size;
   vkCmdCopyBuffer(commandBuffer, *srcBuffer, *dstBuffer, 1, &copyRegion);
+}
 
-  Vulkan__EndSingleTimeCommands(self, &commandBuffer);
+static void CreateVertexBufferSlice(
+    Vulkan_t* self, Vulkan__FrameContext_t* frame, u8 idx, VkDeviceSize size) {
+  Vulkan__CreateBuffer(
+      self,
+      size,
+      VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT |
+          VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+      &frame->vertexBuffers[idx],
+      &frame->vertexBufferAllocations[idx]);
+  frame->vertexBufferSizes[idx] = size;
+  frame->missedCount[idx] = 0;
+  frame->missedAll[idx] = false;
 }
 
 void Vulkan__CreateVertexBuffer(Vulkan_t* self, u8 idx, u64 size, const void* indata) {
   VkDeviceSize bufferSize = size;
 
   VkBuffer stagingBuffer;
-  VkDeviceMemory stagingBufferMemory;
-  Vulkan__CreateBuffer(
-      self,
-      bufferSize,
-      VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-      &stagingBuffer,
-      &stagingBufferMemory);
-
-  void* data;
-  vkMapMemory(self->m_logicalDevice, stagingBufferMemory, 0, bufferSize, 0, &data);
+  void* data = Vulkan__UploadStaging(self, bufferSize, &stagingBuffer);
   memcpy(data, indata, (size_t)bufferSize);
-  vkUnmapMemory(self->m_logicalDevice, stagingBufferMemory);
 
-  Vulkan__CreateBuffer(
-      self,
-      bufferSize,
-      VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-      &self->m_vertexBuffers[idx],
-      &self->m_vertexBufferMemories[idx]);
+  // every frame slot starts out with the same contents
+  for (u8 f = 0; f < self->m_framesInFlight; f++) {
+    CreateVertexBufferSlice(self, &self->m_frames[f], idx, bufferSize);
+    Vulkan__CopyBuffer(self, &stagingBuffer, &self->m_frames[f].vertexBuffers[idx], bufferSize);
+  }
+  self->m_vertexBufferSizes[idx] = bufferSize;
+}
+
+/**
+ * Stage new contents for a vertex buffer through the upload ring.
+ * The copy into the device-local buffer is recorded at the start of the next frame.
+ */
+void Vulkan__UpdateVertexBuffer(Vulkan_t* self, u8 idx, u64 size, const void* indata) {
+  VkBufferCopy region[] = {{.srcOffset = 0, .dstOffset = 0, .size = size}};
+  Vulkan__UpdateVertexBufferRegions(self, idx, indata, 1, region);
+}
 
-  Vulkan__CopyBuffer(self, &stagingBuffer, &self->m_vertexBuffers[idx], bufferSize);
+/**
+ * Copy only the given byte ranges of indata into the vertex buffer at the same offsets.
+ * Each region's srcOffset and dstOffset must be equal; both are relative to indata.
+ */
+void Vulkan__UpdateVertexBufferRegions(
+    Vulkan_t* self, u8 idx, const void* indata, u32 regionsCount, const VkBufferCopy* regions) {
+  ASSERT_CONTEXT(
+      self->m_pendingCopiesCount + regionsCount <= VULKAN_PENDING_COPIES_CAP,
+      "Too many pending copies. Raise VULKAN_PENDING_COPIES_CAP. count: %u",
+      self->m_pendingCopiesCount + regionsCount)
+
+  // pack every region back-to-back into one ring allocation
+  VkDeviceSize size = 0;
+  for (u32 i = 0; i < regionsCount; i++) {
+    size += regions[i].size;
+  }
+  if (0 == size) {
+    return;
+  }
+  VkDeviceSize offset;
+  VkBuffer src = self->m_uploadRing;
+  u8* data = Vulkan__UploadRingAlloc(self, size, &offset);
+  if (NULL == data) {
+    // too big for this frame's ring slice; stage through a one-off buffer instead,
+    // released along with the slice
+    VkBuffer staging;
+    Allocation_t allocation;
+    Vulkan__CreateBuffer(
+        self,
+        size,
+        VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        &staging,
+        &allocation);
+    src = staging;
+    data = allocation.mapped;
+    offset = 0;
+    Vulkan__RetireBuffer(self, &staging, &allocation);
+  }
 
-  vkDestroyBuffer(self->m_logicalDevice, stagingBuffer, NULL);
-  vkFreeMemory(self->m_logicalDevice, stagingBufferMemory, NULL);
+  for (u32 i = 0; i < regionsCount; i++) {
+    memcpy(data, (const u8*)indata + regions[i].srcOffset, (size_t)regions[i].size);
+    data += regions[i].size;
+
+    self->m_pendingCopySrcs[self->m_pendingCopiesCount] = src;
+    self->m_pendingCopyIdxs[self->m_pendingCopiesCount] = idx;
+    self->m_pendingCopies[self->m_pendingCopiesCount].srcOffset = offset;
+    self->m_pendingCopies[self->m_pendingCopiesCount].dstOffset = regions[i].dstOffset;
+    self->m_pendingCopies[self->m_pendingCopiesCount].size = regions[i].size;
+    self->m_pendingCopiesCount++;
+    offset += regions[i].size;
+  }
 }
 
-void Vulkan__UpdateVertexBuffer(Vulkan_t* self, u8 idx, u64 size, const void* indata) {
-  VkDeviceSize bufferSize = size;
+/**
+ * Grow a vertex buffer, without waiting for the device to idle.
+ * Each frame slot is regrown when it next records, carrying over the newest contents on the GPU;
+ * its old buffer is destroyed once no frame in flight can still read it.
+ */
+void Vulkan__GrowVertexBuffer(Vulkan_t* self, u8 idx, u64 size) {
+  if (size <= self->m_vertexBufferSizes[idx]) {
+    return;
+  }
+
+  LOG_DEBUGF(
+      "grew vertex buffer %u from %llu to %llu bytes",
+      idx,
+      (unsigned long long)self->m_vertexBufferSizes[idx],
+      (unsigned long long)size)
+
+  self->m_vertexBufferSizes[idx] = size;
+}
+
+static void DestroyRetired(Vulkan_t* self, Vulkan__Retired_t* retired) {
+  switch (retired->type) {
+    case VULKAN_RETIRED_BUFFER:
+      Vulkan__DestroyBuffer(self, &retired->buffer, &retired->allocation);
+      break;
+    case VULKAN_RETIRED_IMAGE:
+      Vulkan__DestroyImage(self, &retired->image, &retired->allocation);
+      break;
+    case VULKAN_RETIRED_IMAGE_VIEW:
+      vkDestroyImageView(self->m_logicalDevice, retired->imageView, NULL);
+      break;
+    case VULKAN_RETIRED_FRAMEBUFFER:
+      vkDestroyFramebuffer(self->m_logicalDevice, retired->framebuffer, NULL);
+      break;
+    case VULKAN_RETIRED_SWAPCHAIN:
+      vkDestroySwapchainKHR(self->m_logicalDevice, retired->swapChain, NULL);
+      break;
+    case VULKAN_RETIRED_DESCRIPTOR_POOL:
+      // frees the sets allocated from it, too
+      vkDestroyDescriptorPool(self->m_logicalDevice, retired->descriptorPool, NULL);
+      break;
+  }
+}
+
+/**
+ * Queue a handle for destruction once the frame being recorded has completed.
+ * Returns the entry for the caller to fill in.
+ */
+static Vulkan__Retired_t* Retire(Vulkan_t* self, Vulkan__RetiredType_t type) {
+  if (VULKAN_RETIRED_CAP == self->m_retiredCount) {
+    // retiring faster than frames complete; fall back to draining the GPU
+    LOG_DEBUGF("deletion queue is full; waiting for the device to idle.")
+    Vulkan__DeviceWaitIdle(self);
+    // the frame being recorded was never submitted, and may still use its own entries
+    Vulkan__DestroyRetired(self, self->m_frameSerial - 1);
+  }
+  ASSERT_CONTEXT(
+      self->m_retiredCount < VULKAN_RETIRED_CAP,
+      "Too many handles retired in one frame. Raise VULKAN_RETIRED_CAP. count: %u",
+      self->m_retiredCount)
+
+  Vulkan__Retired_t* retired =
+      &self->m_retired[(self->m_retiredHead + self->m_retiredCount++) % VULKAN_RETIRED_CAP];
+  retired->type = type;
+  retired->serial = self->m_frameSerial;
+  retired->allocation.memory = VK_NULL_HANDLE;
+  retired->allocation.mapped = NULL;
+  return retired;
+}
+
+/**
+ * Hand over a buffer for destruction once no frame in flight can still use it.
+ * The handles are cleared.
+ */
+void Vulkan__RetireBuffer(Vulkan_t* self, VkBuffer* buffer, Allocation_t* allocation) {
+  Vulkan__Retired_t* retired = Retire(self, VULKAN_RETIRED_BUFFER);
+  retired->buffer = *buffer;
+  retired->allocation = *allocation;
+  *buffer = VK_NULL_HANDLE;
+  allocation->memory = VK_NULL_HANDLE;
+  allocation->mapped = NULL;
+}
+
+void Vulkan__RetireImage(Vulkan_t* self, VkImage* image, Allocation_t* allocation) {
+  Vulkan__Retired_t* retired = Retire(self, VULKAN_RETIRED_IMAGE);
+  retired->image = *image;
+  retired->allocation = *allocation;
+  *image = VK_NULL_HANDLE;
+  allocation->memory = VK_NULL_HANDLE;
+  allocation->mapped = NULL;
+}
+
+void Vulkan__RetireImageView(Vulkan_t* self, VkImageView* imageView) {
+  Retire(self, VULKAN_RETIRED_IMAGE_VIEW)->imageView = *imageView;
+  *imageView = VK_NULL_HANDLE;
+}
+
+void Vulkan__RetireFramebuffer(Vulkan_t* self, VkFramebuffer* framebuffer) {
+  Retire(self, VULKAN_RETIRED_FRAMEBUFFER)->framebuffer = *framebuffer;
+  *framebuffer = VK_NULL_HANDLE;
+}
+
+void Vulkan__RetireDescriptorPool(Vulkan_t* self, VkDescriptorPool* descriptorPool) {
+  Retire(self, VULKAN_RETIRED_DESCRIPTOR_POOL)->descriptorPool = *descriptorPool;
+  *descriptorPool = VK_NULL_HANDLE;
+}
+
+/**
+ * Destroy every retired handle whose frame serial is at or below completedSerial.
+ */
+void Vulkan__DestroyRetired(Vulkan_t* self, u64 completedSerial) {
+  while (self->m_retiredCount > 0 &&
+         self->m_retired[self->m_retiredHead].serial <= completedSerial) {
+    DestroyRetired(self, &self->m_retired[self->m_retiredHead]);
+    self->m_retiredHead = (self->m_retiredHead + 1) % VULKAN_RETIRED_CAP;
+    self->m_retiredCount--;
+  }
+}
+
+void Vulkan__CreateCullPipeline(Vulkan_t* self, const char* comp_shader) {
+  VkDescriptorSetLayoutCreateInfo layoutInfo;
+  layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+  layoutInfo.pNext = NULL;
+  layoutInfo.flags = 0;
+  layoutInfo.bindingCount = 5;
+  layoutInfo.pBindings = (VkDescriptorSetLayoutBinding[]){
+      {
+          .binding = 0,
+          .descriptorCount = 1,
+          .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+          .pImmutableSamplers = NULL,
+          .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+      },
+      {
+          .binding = 1,
+          .descriptorCount = 1,
+          .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+          .pImmutableSamplers = NULL,
+          .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+      },
+      {
+          .binding = 2,
+          .descriptorCount = 1,
+          .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+          .pImmutableSamplers = NULL,
+          .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+      },
+      {
+          .binding = 3,
+          .descriptorCount = 1,
+          .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+          .pImmutableSamplers = NULL,
+          .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+      },
+      {
+          .binding = 4,
+          .descriptorCount = 1,
+          .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+          .pImmutableSamplers = NULL,
+          .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+      },
+  };
+
+  ASSERT(
+      VK_SUCCESS == vkCreateDescriptorSetLayout(
+                        self->m_logicalDevice,
+                        &layoutInfo,
+                        NULL,
+                        &self->m_cullDescriptorSetLayout))
+
+  VkDescriptorPoolSize poolSizes[] = {
+      {
+          .type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+          .descriptorCount = (u32)(self->m_framesInFlight),
+      },
+      {
+          .type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+          .descriptorCount = (u32)(self->m_framesInFlight) * 4,
+      },
+  };
+
+  VkDescriptorPoolCreateInfo poolInfo;
+  poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+  poolInfo.pNext = NULL;
+  poolInfo.flags = 0;
+  poolInfo.maxSets = (u32)(self->m_framesInFlight);
+  poolInfo.poolSizeCount = ARRAY_COUNT(poolSizes);
+  poolInfo.pPoolSizes = poolSizes;
+
+  ASSERT(
+      VK_SUCCESS ==
+      vkCreateDescriptorPool(self->m_logicalDevice, &poolInfo, NULL, &self->m_cullDescriptorPool))
+
+  VkDescriptorSetLayout layouts[VULKAN_FRAMES_IN_FLIGHT_CAP];
+  VkDescriptorSet sets[VULKAN_FRAMES_IN_FLIGHT_CAP];
+  for (u8 i = 0; i < self->m_framesInFlight; i++) {
+    layouts[i] = self->m_cullDescriptorSetLayout;
+  }
+
+  VkDescriptorSetAllocateInfo allocInfo;
+  allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+  allocInfo.pNext = NULL;
+  allocInfo.descriptorPool = self->m_cullDescriptorPool;
+  allocInfo.descriptorSetCount = (u32)(self->m_framesInFlight);
+  allocInfo.pSetLayouts = layouts;
+
+  ASSERT(VK_SUCCESS == vkAllocateDescriptorSets(self->m_logicalDevice, &allocInfo, sets))
+  for (u8 i = 0; i < self->m_framesInFlight; i++) {
+    self->m_frames[i].cullDescriptorSet = sets[i];
+    // written lazily, once the culled instance buffer exists
+    self->m_frames[i].cullDescriptorsStale = true;
+  }
+
+  // batch first instance, batch instance count, pass, index count, batch index
+  VkPushConstantRange pushConstantRange;
+  pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+  pushConstantRange.offset = 0;
+  pushConstantRange.size = sizeof(u32) * 5;
+
+  VkPipelineLayoutCreateInfo pipelineLayoutInfo;
+  pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+  pipelineLayoutInfo.pNext = NULL;
+  pipelineLayoutInfo.flags = 0;
+  pipelineLayoutInfo.setLayoutCount = 1;
+  pipelineLayoutInfo.pSetLayouts = &self->m_cullDescriptorSetLayout;
+  pipelineLayoutInfo.pushConstantRangeCount = 1;
+  pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+
+  ASSERT(
+      VK_SUCCESS == vkCreatePipelineLayout(
+                        self->m_logicalDevice,
+                        &pipelineLayoutInfo,
+                        NULL,
+                        &self->m_cullPipelineLayout))
+
+  const u64 start = Now();
+  const char shader[VULKAN_SHADER_FILE_BUFFER_BYTES_CAP];
+  u64 len = Shader__ReadFile((char*)&shader, comp_shader);
+  VkShaderModule compShaderModule;
+  Vulkan__CreateShaderModule(self, len, shader, &compShaderModule);
+
+  VkComputePipelineCreateInfo pipelineInfo;
+  pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+  pipelineInfo.pNext = NULL;
+  pipelineInfo.flags = 0;
+  pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+  pipelineInfo.stage.pNext = NULL;
+  pipelineInfo.stage.flags = 0;
+  pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+  pipelineInfo.stage.module = compShaderModule;
+  pipelineInfo.stage.pName = "main";
+  pipelineInfo.stage.pSpecializationInfo = NULL;
+  pipelineInfo.layout = self->m_cullPipelineLayout;
+  pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+  pipelineInfo.basePipelineIndex = -1;
+
+  ASSERT(
+      VK_SUCCESS == vkCreateComputePipelines(
+                        self->m_logicalDevice,
+                        self->m_pipelineCache,
+                        1,
+                        &pipelineInfo,
+                        NULL,
+                        &self->m_cullPipeline))
+
+  Vulkan__DestroyShaderModule(self, &compShaderModule);
+
+  LOG_INFOF(
+      "created cull pipeline. cache: %s, ms: %.3f",
+      !self->m_pipelineCache ? "none" : self->m_pipelineCacheWarm ? "warm" : "cold",
+      (f64)(Now() - start) / CYCLES_PER_MILLISECOND)
+
+  for (u8 i = 0; i < self->m_framesInFlight; i++) {
+    Vulkan__CreateBuffer(
+        self,
+        sizeof(VkDrawIndexedIndirectCommand) * VULKAN_CULL_DRAWS_CAP,
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        &self->m_frames[i].indirectBuffer,
+        &self->m_frames[i].indirectBufferAllocation);
+    self->m_frames[i].culledInstancesSize = 0;
+  }
+}
+
+/**
+ * Record the culling passes, ahead of the render pass; once for each draw batch.
+ * Leaves the frame's culledInstances and indirectBuffer ready for vkCmdDrawIndexedIndirect().
+ */
+void Vulkan__RecordCull(Vulkan_t* self, VkCommandBuffer* commandBuffer) {
+  // nothing in flight reads this slot's outputs any more; its fence has signaled
+  Vulkan__FrameContext_t* frame = &self->m_frames[self->m_currentFrame];
+  const VkDeviceSize size = frame->vertexBufferSizes[1];
+  if (frame->culledInstancesSize < size) {
+    // follow the instance buffer; prior contents don't matter
+    if (frame->culledInstances) {
+      Vulkan__RetireBuffer(self, &frame->culledInstances, &frame->culledInstancesAllocation);
+      Vulkan__RetireBuffer(self, &frame->cullGroups, &frame->cullGroupsAllocation);
+    }
+    Vulkan__CreateBuffer(
+        self,
+        size,
+        VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        &frame->culledInstances,
+        &frame->culledInstancesAllocation);
+    // bytes bound the instance count from above; close enough for one u32 per workgroup
+    const u64 groupsCount = (size + VULKAN_CULL_GROUP_SIZE - 1) / VULKAN_CULL_GROUP_SIZE;
+    Vulkan__CreateBuffer(
+        self,
+        groupsCount * sizeof(u32),
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        &frame->cullGroups,
+        &frame->cullGroupsAllocation);
+    frame->culledInstancesSize = size;
+    frame->cullDescriptorsStale = true;
+    frame->drawSecondariesStale = true;
+  }
+
+  if (frame->cullDescriptorsStale) {
+    frame->cullDescriptorsStale = false;
+
+    VkDescriptorBufferInfo bufferInfos[] = {
+        {frame->uniformBuffer, 0, self->m_uniformBufferLength},
+        {frame->vertexBuffers[1], 0, VK_WHOLE_SIZE},
+        {frame->culledInstances, 0, VK_WHOLE_SIZE},
+        {frame->indirectBuffer, 0, VK_WHOLE_SIZE},
+        {frame->cullGroups, 0, VK_WHOLE_SIZE},
+    };
+    VkWriteDescriptorSet descriptorWrites[ARRAY_COUNT(bufferInfos)];
+    for (u8 i = 0; i < ARRAY_COUNT(bufferInfos); i++) {
+      descriptorWrites[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+      descriptorWrites[i].pNext = NULL;
+      descriptorWrites[i].dstSet = frame->cullDescriptorSet;
+      descriptorWrites[i].dstBinding = i;
+      descriptorWrites[i].dstArrayElement = 0;
+      descriptorWrites[i].descriptorType =
+          0 == i ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+      descriptorWrites[i].descriptorCount = 1;
+      descriptorWrites[i].pBufferInfo = &bufferInfos[i];
+      descriptorWrites[i].pImageInfo = NULL;
+      descriptorWrites[i].pTexelBufferView = NULL;
+    }
+    vkUpdateDescriptorSets(
+        self->m_logicalDevice,
+        ARRAY_COUNT(descriptorWrites),
+        descriptorWrites,
+        0,
+        NULL);
+  }
+
+  // uploads must land before reading
+  VkMemoryBarrier before[] = {{
+      .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+      .pNext = NULL,
+      .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+      .dstAccessMask = VK_ACCESS_SHADER_READ_BIT,
+  }};
+  vkCmdPipelineBarrier(
+      *commandBuffer,
+      VK_PIPELINE_STAGE_TRANSFER_BIT,
+      VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+      0,
+      1,
+      before,
+      0,
+      NULL,
+      0,
+      NULL);
+
+  vkCmdBindPipeline(*commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, self->m_cullPipeline);
+  vkCmdBindDescriptorSets(
+      *commandBuffer,
+      VK_PIPELINE_BIND_POINT_COMPUTE,
+      self->m_cullPipelineLayout,
+      0,
+      1,
+      &frame->cullDescriptorSet,
+      0,
+      NULL);
+
+  // each batch is compacted within its own span, so the draws keep their order and pipelines;
+  // the batches share the group offsets, one after another
+  const Vulkan__DrawBatch_t all = {0, self->m_instanceCount, VULKAN_PIPELINE_OPAQUE};
+  const u32 batchesCount = self->m_drawBatchesCount > 0 ? self->m_drawBatchesCount : 1;
+  const Vulkan__DrawBatch_t* batches = self->m_drawBatchesCount > 0 ? self->m_drawBatches : &all;
+  for (u32 b = 0; b < batchesCount; b++) {
+    const u32 groupsCount = (batches[b].instanceCount + VULKAN_CULL_GROUP_SIZE - 1) /
+                            VULKAN_CULL_GROUP_SIZE;
+    const u32 groups[] = {groupsCount, 1, groupsCount};
+    for (u32 pass = 0; pass < ARRAY_COUNT(groups); pass++) {
+      if (b > 0 || pass > 0) {
+        VkMemoryBarrier between[] = {{
+            .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+            .pNext = NULL,
+            .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+            .dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+        }};
+        vkCmdPipelineBarrier(
+            *commandBuffer,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            0,
+            1,
+            between,
+            0,
+            NULL,
+            0,
+            NULL);
+      }
+      const u32 push[] = {
+          batches[b].firstInstance,
+          batches[b].instanceCount,
+          pass,
+          self->m_drawIndexCount,
+          b,
+      };
+      vkCmdPushConstants(
+          *commandBuffer,
+          self->m_cullPipelineLayout,
+          VK_SHADER_STAGE_COMPUTE_BIT,
+          0,
+          sizeof(push),
+          push);
+      vkCmdDispatch(*commandBuffer, groups[pass], 1, 1);
+    }
+  }
+
+  VkMemoryBarrier after[] = {{
+      .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+      .pNext = NULL,
+      .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+      .dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT,
+  }};
+  vkCmdPipelineBarrier(
+      *commandBuffer,
+      VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+      VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+      0,
+      1,
+      after,
+      0,
+      NULL,
+      0,
+      NULL);
+}
+
+void Vulkan__CreateUploadRing(Vulkan_t* self, u64 frameBytes) {
+  VkDeviceSize bufferSize = frameBytes * self->m_framesInFlight;
 
-  VkBuffer stagingBuffer;
-  VkDeviceMemory stagingBufferMemory;
   Vulkan__CreateBuffer(
       self,
       bufferSize,
       VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
       VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-      &stagingBuffer,
-      &stagingBufferMemory);
+      &self->m_uploadRing,
+      &self->m_uploadRingAllocation);
 
-  void* data;
-  vkMapMemory(self->m_logicalDevice, stagingBufferMemory, 0, bufferSize, 0, &data);
-  memcpy(data, indata, (size_t)bufferSize);
-  vkUnmapMemory(self->m_logicalDevice, stagingBufferMemory);
+  // host-visible allocations stay mapped for their lifetime
+  self->m_uploadRingMapped = self->m_uploadRingAllocation.mapped;
 
-  Vulkan__CopyBuffer(self, &stagingBuffer, &self->m_vertexBuffers[idx], bufferSize);
+  self->m_uploadRingFrameBytes = frameBytes;
+  self->m_uploadRingHead = 0;
+  self->m_pendingCopiesCount = 0;
+}
+
+/**
+ * Sub-allocate from the current frame's slice of the upload ring.
+ * Returns the mapped pointer to write to; offset receives the position within m_uploadRing.
+ * Returns NULL when the slice has no room left.
+ */
+void* Vulkan__UploadRingAlloc(Vulkan_t* self, VkDeviceSize size, VkDeviceSize* offset) {
+  const VkDeviceSize head = (self->m_uploadRingHead + (VULKAN_UPLOAD_RING_ALIGNMENT - 1)) &
+                            ~((VkDeviceSize)VULKAN_UPLOAD_RING_ALIGNMENT - 1);
+  if (head + size > self->m_uploadRingFrameBytes) {
+    return NULL;
+  }
+  self->m_uploadRingHead = head + size;
 
-  vkDestroyBuffer(self->m_logicalDevice, stagingBuffer, NULL);
-  vkFreeMemory(self->m_logicalDevice, stagingBufferMemory, NULL);
+  *offset = (self->m_currentFrame * self->m_uploadRingFrameBytes) + head;
+  return self->m_uploadRingMapped + *offset;
+}
+
+// whether the current slot is behind on any vertex buffer
+static bool NeedsCatchUp(Vulkan_t* self) {
+  const Vulkan__FrameContext_t* frame = &self->m_frames[self->m_currentFrame];
+  for (u8 idx = 0; idx < VULKAN_VERTEX_BUFFERS_CAP; idx++) {
+    if (frame->vertexBufferSizes[idx] < self->m_vertexBufferSizes[idx] ||
+        frame->missedAll[idx] || frame->missedCount[idx] > 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static void TransferBarrier(VkCommandBuffer* commandBuffer) {
+  VkMemoryBarrier barrier[] = {{
+      .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+      .pNext = NULL,
+      .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+      .dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT,
+  }};
+  vkCmdPipelineBarrier(
+      *commandBuffer,
+      VK_PIPELINE_STAGE_TRANSFER_BIT,
+      VK_PIPELINE_STAGE_TRANSFER_BIT,
+      0,
+      1,
+      barrier,
+      0,
+      NULL,
+      0,
+      NULL);
+}
+
+/**
+ * Bring the current slot's vertex buffers up to date, then apply this frame's updates to them.
+ * The slot's fence has signaled, so nothing on the GPU still reads its buffers;
+ * only the previous slot, which the catch-up copies from, may still be in flight.
+ */
+void Vulkan__RecordPendingCopies(Vulkan_t* self, VkCommandBuffer* commandBuffer) {
+  const bool catchUp = NeedsCatchUp(self);
+  if (0 == self->m_pendingCopiesCount && !catchUp) {
+    return;
+  }
+
+  const u8 current = self->m_currentFrame;
+  Vulkan__FrameContext_t* frame = &self->m_frames[current];
+  Vulkan__FrameContext_t* previous =
+      &self->m_frames[(current + self->m_framesInFlight - 1) % self->m_framesInFlight];
+
+  if (catchUp) {
+    // the previous slot's copies must land before reading them, and
+    // earlier reads of this slot (as a copy source) must finish before overwriting it
+    TransferBarrier(commandBuffer);
+
+    for (u8 idx = 0; idx < VULKAN_VERTEX_BUFFERS_CAP; idx++) {
+      const VkDeviceSize size = self->m_vertexBufferSizes[idx];
+      if (0 == size) {
+        continue;
+      }
+      // with one slot, the newest contents are the slot's own
+      const VkBuffer src = previous->vertexBuffers[idx];
+      const VkDeviceSize srcSize = previous->vertexBufferSizes[idx];
+      if (frame->vertexBufferSizes[idx] < size) {
+        // the old slice stays valid as a copy source until the slot comes around again
+        Vulkan__RetireBuffer(
+            self,
+            &frame->vertexBuffers[idx],
+            &frame->vertexBufferAllocations[idx]);
+        CreateVertexBufferSlice(self, frame, idx, size);
+        frame->missedAll[idx] = true;
+        frame->cullDescriptorsStale = true;
+        frame->drawSecondariesStale = true;
+      }
+      if (frame->missedAll[idx]) {
+        VkBufferCopy region = {0, 0, MATH_MIN(srcSize, size)};
+        vkCmdCopyBuffer(*commandBuffer, src, frame->vertexBuffers[idx], 1, &region);
+      } else if (frame != previous && frame->missedCount[idx] > 0) {
+        vkCmdCopyBuffer(
+            *commandBuffer,
+            src,
+            frame->vertexBuffers[idx],
+            frame->missedCount[idx],
+            frame->missed[idx]);
+      }
+      frame->missedCount[idx] = 0;
+      frame->missedAll[idx] = false;
+    }
+  }
+
+  if (self->m_pendingCopiesCount > 0) {
+    // updates overwrite parts of the carried-over contents; order them after it
+    TransferBarrier(commandBuffer);
+
+    // one command per run of copies between the same pair of buffers
+    u32 first = 0;
+    for (u32 i = 1; i <= self->m_pendingCopiesCount; i++) {
+      if (i < self->m_pendingCopiesCount &&
+          self->m_pendingCopySrcs[i] == self->m_pendingCopySrcs[first] &&
+          self->m_pendingCopyIdxs[i] == self->m_pendingCopyIdxs[first]) {
+        continue;
+      }
+      vkCmdCopyBuffer(
+          *commandBuffer,
+          self->m_pendingCopySrcs[first],
+          frame->vertexBuffers[self->m_pendingCopyIdxs[first]],
+          i - first,
+          &self->m_pendingCopies[first]);
+      first = i;
+    }
+
+    // the other slots pick these up from here when they next record
+    for (u8 f = 0; f < self->m_framesInFlight; f++) {
+      if (f == current) {
+        continue;
+      }
+      Vulkan__FrameContext_t* other = &self->m_frames[f];
+      for (u32 i = 0; i < self->m_pendingCopiesCount; i++) {
+        const u8 idx = self->m_pendingCopyIdxs[i];
+        if (other->missedAll[idx]) {
+          continue;
+        }
+        if (other->missedCount[idx] == VULKAN_MISSED_COPIES_CAP) {
+          other->missedAll[idx] = true;
+          other->missedCount[idx] = 0;
+          continue;
+        }
+        VkBufferCopy* region = &other->missed[idx][other->missedCount[idx]++];
+        region->srcOffset = self->m_pendingCopies[i].dstOffset;
+        region->dstOffset = self->m_pendingCopies[i].dstOffset;
+        region->size = self->m_pendingCopies[i].size;
+      }
+    }
+  }
+
+  VkMemoryBarrier after[] = {{
+      .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+      .pNext = NULL,
+      .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+      .dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_SHADER_READ_BIT,
+  }};
+  vkCmdPipelineBarrier(
+      *commandBuffer,
+      VK_PIPELINE_STAGE_TRANSFER_BIT,
+      VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+      0,
+      1,
+      after,
+      0,
+      NULL,
+      0,
+      NULL);
+
+  self->m_pendingCopiesCount = 0;
 }
 
 void Vulkan__CreateIndexBuffer(Vulkan_t* self, u64 size, const void* indata) {
   VkDeviceSize bufferSize = size;
 
   VkBuffer stagingBuffer;
-  VkDeviceMemory stagingBufferMemory;
-  Vulkan__CreateBuffer(
-      self,
-      bufferSize,
-      VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-      &stagingBuffer,
-      &stagingBufferMemory);
-
-  void* data;
-  vkMapMemory(self->m_logicalDevice, stagingBufferMemory, 0, bufferSize, 0, &data);
+  void* data = Vulkan__UploadStaging(self, bufferSize, &stagingBuffer);
   memcpy(data, indata, (size_t)bufferSize);
-  vkUnmapMemory(self->m_logicalDevice, stagingBufferMemory);
 
   Vulkan__CreateBuffer(
       self,
@@ -1461,60 +2926,78 @@ void Vulkan__CreateIndexBuffer(Vulkan_t* self, u64 size, const void* indata) {
       VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
       VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
       &self->m_indexBuffer,
-      &self->m_indexBufferMemory);
+      &self->m_indexBufferAllocation);
 
   Vulkan__CopyBuffer(self, &stagingBuffer, &self->m_indexBuffer, bufferSize);
+}
 
-  vkDestroyBuffer(self->m_logicalDevice, stagingBuffer, NULL);
-  vkFreeMemory(self->m_logicalDevice, stagingBufferMemory, NULL);
+void Vulkan__CreateAtlasBuffer(Vulkan_t* self, u64 size, const void* indata) {
+  VkDeviceSize bufferSize = size;
+  self->m_atlasBufferSize = size;
+
+  VkBuffer stagingBuffer;
+  void* data = Vulkan__UploadStaging(self, bufferSize, &stagingBuffer);
+  memcpy(data, indata, (size_t)bufferSize);
+
+  Vulkan__CreateBuffer(
+      self,
+      bufferSize,
+      VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+      &self->m_atlasBuffer,
+      &self->m_atlasBufferAllocation);
+
+  Vulkan__CopyBuffer(self, &stagingBuffer, &self->m_atlasBuffer, bufferSize);
 }
 
 void Vulkan__CreateUniformBuffers(Vulkan_t* self, const unsigned int length) {
   VkDeviceSize bufferSize = length;
 
-  for (size_t i = 0; i < self->m_SwapChain__images_count; i++) {
-    self->m_uniformBufferLengths[i] = length;
+  self->m_uniformBufferLength = length;
+  for (u8 i = 0; i < self->m_framesInFlight; i++) {
+    Vulkan__FrameContext_t* frame = &self->m_frames[i];
     Vulkan__CreateBuffer(
         self,
         bufferSize,
         VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
         VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-        &self->m_uniformBuffers[i],
-        &self->m_uniformBuffersMemory[i]);
+        &frame->uniformBuffer,
+        &frame->uniformBufferAllocation);
 
-    ASSERT(
-        VK_SUCCESS == vkMapMemory(
-                          self->m_logicalDevice,
-                          self->m_uniformBuffersMemory[i],
-                          0,
-                          bufferSize,
-                          0,
-                          &self->m_uniformBuffersMapped[i]))
+    frame->uniformBufferMapped = frame->uniformBufferAllocation.mapped;
   }
 }
 
 void Vulkan__UpdateUniformBuffer(Vulkan_t* self, u8 frame, void* ubo) {
-  memcpy(self->m_uniformBuffersMapped[frame], ubo, self->m_uniformBufferLengths[frame]);
+  memcpy(self->m_frames[frame].uniformBufferMapped, ubo, self->m_uniformBufferLength);
 }
 
+/**
+ * Sized for one set per frame slot, each with a texture array of m_texturesCap elements.
+ * When the texture table grows, the pool is replaced; see GrowTextures().
+ */
 void Vulkan__CreateDescriptorPool(Vulkan_t* self) {
   VkDescriptorPoolSize poolSizes[] = {
       {
           .type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
-          .descriptorCount = (u32)(self->m_SwapChain__images_count),
+          .descriptorCount = (u32)(self->m_framesInFlight),
+      },
+      {
+          .type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+          .descriptorCount = (u32)(self->m_framesInFlight),
       },
       {
           .type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-          .descriptorCount = (u32)(self->m_SwapChain__images_count),
+          .descriptorCount = (u32)(self->m_framesInFlight) * MATH_MAX(self->m_texturesCap, 1),
       },
   };
 
   VkDescriptorPoolCreateInfo poolInfo;
   poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
   poolInfo.pNext = NULL;
-  poolInfo.flags = 0;
-  poolInfo.maxSets = (u32)(self->m_SwapChain__images_count);
-  poolInfo.poolSizeCount = (u32)(self->m_SwapChain__images_count);
+  poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+  poolInfo.maxSets = (u32)(self->m_framesInFlight);
+  poolInfo.poolSizeCount = ARRAY_COUNT(poolSizes);
   poolInfo.pPoolSizes = poolSizes;
 
   ASSERT(
@@ -1522,39 +3005,88 @@ void Vulkan__CreateDescriptorPool(Vulkan_t* self) {
       vkCreateDescriptorPool(self->m_logicalDevice, &poolInfo, NULL, &self->m_descriptorPool))
 }
 
+/**
+ * Write every texture in use into a set's texture array, as one write per run of used handles;
+ * those not resident yet are written as the placeholder, with their own sampler.
+ * Unused elements are skipped; the array is partially bound, and no instance selects them.
+ */
+static void WriteTextureDescriptors(Vulkan_t* self, VkDescriptorSet descriptorSet) {
+  u32 first = 0;
+  for (u32 i = 0; i <= self->m_texturesCap; i++) {
+    if (i < self->m_texturesCap && self->m_textures[i].used) {
+      const Vulkan__Texture_t* texture = &self->m_textures[i];
+      const Vulkan__Texture_t* bound = texture->resident ? texture : &self->m_placeholderTexture;
+      self->m_textureInfos[i].imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+      self->m_textureInfos[i].imageView = bound->imageView;
+      self->m_textureInfos[i].sampler = self->m_textureSamplers[texture->filter];
+      continue;
+    }
+
+    if (i > first) {
+      VkWriteDescriptorSet descriptorWrite;
+      descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+      descriptorWrite.pNext = NULL;
+      descriptorWrite.dstSet = descriptorSet;
+      descriptorWrite.dstBinding = 2;
+      descriptorWrite.dstArrayElement = first;
+      descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+      descriptorWrite.descriptorCount = i - first;
+      descriptorWrite.pImageInfo = &self->m_textureInfos[first];
+
+      vkUpdateDescriptorSets(self->m_logicalDevice, 1, &descriptorWrite, 0, NULL);
+    }
+    first = i + 1;
+  }
+}
+
 void Vulkan__CreateDescriptorSets(Vulkan_t* self) {
-  VkDescriptorSetLayout layouts[self->m_SwapChain__images_count];
-  for (u8 i = 0; i < self->m_SwapChain__images_count; i++) {
+  VkDescriptorSetLayout layouts[VULKAN_FRAMES_IN_FLIGHT_CAP];
+  VkDescriptorSet sets[VULKAN_FRAMES_IN_FLIGHT_CAP];
+  for (u8 i = 0; i < self->m_framesInFlight; i++) {
     layouts[i] = self->m_descriptorSetLayout;
   };
 
+  // every set's texture array holds the whole table
+  u32 texturesCounts[VULKAN_FRAMES_IN_FLIGHT_CAP];
+  for (u8 i = 0; i < self->m_framesInFlight; i++) {
+    texturesCounts[i] = self->m_texturesCap;
+  }
+  VkDescriptorSetVariableDescriptorCountAllocateInfo countInfo;
+  countInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_VARIABLE_DESCRIPTOR_COUNT_ALLOCATE_INFO;
+  countInfo.pNext = NULL;
+  countInfo.descriptorSetCount = (u32)(self->m_framesInFlight);
+  countInfo.pDescriptorCounts = texturesCounts;
+
   VkDescriptorSetAllocateInfo allocInfo;
   allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-  allocInfo.pNext = NULL;
+  allocInfo.pNext = &countInfo;
   allocInfo.descriptorPool = self->m_descriptorPool;
-  allocInfo.descriptorSetCount = (u32)(self->m_SwapChain__images_count);
+  allocInfo.descriptorSetCount = (u32)(self->m_framesInFlight);
   allocInfo.pSetLayouts = layouts;
 
   ASSERT(
       VK_SUCCESS ==
-      vkAllocateDescriptorSets(self->m_logicalDevice, &allocInfo, self->m_descriptorSets))
+      vkAllocateDescriptorSets(self->m_logicalDevice, &allocInfo, sets))
+
+  for (u8 i = 0; i < self->m_framesInFlight; i++) {
+    Vulkan__FrameContext_t* frame = &self->m_frames[i];
+    frame->descriptorSet = sets[i];
 
-  for (u8 i = 0; i < self->m_SwapChain__images_count; i++) {
     VkDescriptorBufferInfo bufferInfo;
-    bufferInfo.buffer = self->m_uniformBuffers[i];
+    bufferInfo.buffer = frame->uniformBuffer;
     bufferInfo.offset = 0;
-    bufferInfo.range = self->m_uniformBufferLengths[i];
+    bufferInfo.range = self->m_uniformBufferLength;
 
-    VkDescriptorImageInfo imageInfo;
-    imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-    imageInfo.imageView = self->m_textureImageView;
-    imageInfo.sampler = self->m_textureSampler;
+    VkDescriptorBufferInfo atlasInfo;
+    atlasInfo.buffer = self->m_atlasBuffer;
+    atlasInfo.offset = 0;
+    atlasInfo.range = self->m_atlasBufferSize;
 
     u32 descriptorCount = 2;
     VkWriteDescriptorSet descriptorWrites[descriptorCount];
     descriptorWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
     descriptorWrites[0].pNext = NULL;
-    descriptorWrites[0].dstSet = self->m_descriptorSets[i];
+    descriptorWrites[0].dstSet = frame->descriptorSet;
     descriptorWrites[0].dstBinding = 0;
     descriptorWrites[0].dstArrayElement = 0;
     descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
@@ -1563,15 +3095,19 @@ void Vulkan__CreateDescriptorSets(Vulkan_t* self) {
 
     descriptorWrites[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
     descriptorWrites[1].pNext = NULL;
-    descriptorWrites[1].dstSet = self->m_descriptorSets[i];
+    descriptorWrites[1].dstSet = frame->descriptorSet;
     descriptorWrites[1].dstBinding = 1;
     descriptorWrites[1].dstArrayElement = 0;
-    descriptorWrites[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    descriptorWrites[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
     descriptorWrites[1].descriptorCount = 1;
-    descriptorWrites[1].pImageInfo = &imageInfo;
+    descriptorWrites[1].pBufferInfo = &atlasInfo;
 
     vkUpdateDescriptorSets(self->m_logicalDevice, descriptorCount, descriptorWrites, 0, NULL);
+
+    WriteTextureDescriptors(self, frame->descriptorSet);
+    frame->textureDescriptorsStale = false;
   }
+  Vulkan__InvalidateDrawCommands(self, VULKAN_DIRTY_DESCRIPTORS);
 }
 
 void Vulkan__CreateCommandBuffers(Vulkan_t* self) {
@@ -1580,11 +3116,239 @@ void Vulkan__CreateCommandBuffers(Vulkan_t* self) {
   allocInfo.pNext = NULL;
   allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
   allocInfo.commandPool = self->m_commandPool;
-  allocInfo.commandBufferCount = self->m_SwapChain__images_count;
 
-  ASSERT(
-      VK_SUCCESS ==
-      vkAllocateCommandBuffers(self->m_logicalDevice, &allocInfo, self->m_commandBuffers))
+  for (u8 f = 0; f < self->m_framesInFlight; f++) {
+    Vulkan__FrameContext_t* frame = &self->m_frames[f];
+    allocInfo.commandBufferCount = 1;
+    ASSERT(
+        VK_SUCCESS ==
+        vkAllocateCommandBuffers(self->m_logicalDevice, &allocInfo, &frame->commandBuffer))
+
+    // every image the swapchain could be recreated with; they are only recorded once used
+    allocInfo.commandBufferCount = VULKAN_SWAPCHAIN_IMAGES_CAP;
+    ASSERT(
+        VK_SUCCESS ==
+        vkAllocateCommandBuffers(self->m_logicalDevice, &allocInfo, frame->drawCommandBuffers))
+    for (u8 i = 0; i < VULKAN_SWAPCHAIN_IMAGES_CAP; i++) {
+      frame->drawCommandsStale[i] = true;
+    }
+  }
+  self->m_drawDirty = 0;
+}
+
+void Vulkan__InvalidateDrawCommands(Vulkan_t* self, u32 dirty) {
+  self->m_drawDirty |= dirty;
+}
+
+void Vulkan__SetInstanceCount(Vulkan_t* self, u32 count) {
+  if (count != self->m_instanceCount) {
+    self->m_instanceCount = count;
+    Vulkan__InvalidateDrawCommands(self, VULKAN_DIRTY_INSTANCE_COUNT);
+  }
+}
+
+/**
+ * Split the instances into batches, ie. sprite layers; count 0 draws them all as one.
+ * When culling on the GPU, each batch is culled on its own, then drawn indirectly.
+ */
+void Vulkan__SetDrawBatches(Vulkan_t* self, u32 count, const Vulkan__DrawBatch_t* batches) {
+  ASSERT_CONTEXT(
+      count <= VULKAN_DRAW_BATCHES_CAP,
+      "Too many draw batches. count: %u, cap: %u",
+      count,
+      VULKAN_DRAW_BATCHES_CAP)
+  ASSERT_CONTEXT(
+      !self->m_gpuCull || count <= VULKAN_CULL_DRAWS_CAP,
+      "Too many draw batches to cull on the GPU. count: %u, cap: %u",
+      count,
+      VULKAN_CULL_DRAWS_CAP)
+  if (count == self->m_drawBatchesCount &&
+      0 == memcmp(batches, self->m_drawBatches, count * sizeof(Vulkan__DrawBatch_t))) {
+    return;
+  }
+  memcpy(self->m_drawBatches, batches, count * sizeof(Vulkan__DrawBatch_t));
+  self->m_drawBatchesCount = count;
+  Vulkan__InvalidateDrawCommands(self, VULKAN_DIRTY_INSTANCE_COUNT);
+}
+
+void Vulkan__CreateRecorders(Vulkan_t* self, Jobs_t* jobs) {
+  self->m_jobs = jobs;
+
+  for (u32 t = 0; t < jobs->m_threadsCount; t++) {
+    VkCommandPoolCreateInfo poolInfo;
+    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.pNext = NULL;
+    poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    poolInfo.queueFamilyIndex = self->m_SwapChain__queues.graphics__index;
+    ASSERT(
+        VK_SUCCESS ==
+        vkCreateCommandPool(self->m_logicalDevice, &poolInfo, NULL, &self->m_recordPools[t]))
+
+    VkCommandBufferAllocateInfo allocInfo;
+    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.pNext = NULL;
+    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+    allocInfo.commandPool = self->m_recordPools[t];
+    allocInfo.commandBufferCount = 1;
+    for (u8 f = 0; f < self->m_framesInFlight; f++) {
+      ASSERT(
+          VK_SUCCESS == vkAllocateCommandBuffers(
+                            self->m_logicalDevice,
+                            &allocInfo,
+                            &self->m_frames[f].drawSecondaries[t]))
+    }
+  }
+
+  for (u8 f = 0; f < self->m_framesInFlight; f++) {
+    self->m_frames[f].drawSecondariesStale = true;
+  }
+}
+
+typedef struct {
+  Vulkan_t* self;
+  u8 frame;
+  u32 jobsCount;
+  u32 batchesCount;
+  const Vulkan__DrawBatch_t* batches;
+} Vulkan__RecordJob_t;
+
+// runs on a job thread; touches only this job's command buffer and pool
+static void RecordDrawJob(void* data, u32 job) {
+  const Vulkan__RecordJob_t* ctx = data;
+  Vulkan_t* self = ctx->self;
+  const Vulkan__FrameContext_t* frame = &self->m_frames[ctx->frame];
+  VkCommandBuffer commandBuffer = frame->drawSecondaries[job];
+
+  ASSERT(VK_SUCCESS == vkResetCommandBuffer(commandBuffer, 0))
+
+  VkCommandBufferInheritanceInfo inheritanceInfo;
+  inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+  inheritanceInfo.pNext = NULL;
+  inheritanceInfo.renderPass = self->m_renderPass;
+  inheritanceInfo.subpass = 0;
+  inheritanceInfo.framebuffer = VK_NULL_HANDLE;  // any image
+  inheritanceInfo.occlusionQueryEnable = VK_FALSE;
+  inheritanceInfo.queryFlags = 0;
+  inheritanceInfo.pipelineStatistics = 0;
+
+  VkCommandBufferBeginInfo beginInfo;
+  beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+  beginInfo.pNext = NULL;
+  // every cached primary of the slot, one per swapchain image, executes the same secondaries;
+  // without simultaneous use, recording one into a primary invalidates the others holding it
+  beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT |
+                    VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
+  beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+  ASSERT(VK_SUCCESS == vkBeginCommandBuffer(commandBuffer, &beginInfo))
+
+  // secondaries inherit no state from the primary
+  Vulkan__Pipeline_t bound = VULKAN_PIPELINE_OPAQUE;
+  vkCmdBindPipeline(
+      commandBuffer,
+      VK_PIPELINE_BIND_POINT_GRAPHICS,
+      self->m_graphicsPipelines[bound]);
+
+  VkDeviceSize offsets[VULKAN_VERTEX_BUFFERS_CAP];
+  VkBuffer vertexBuffers[VULKAN_VERTEX_BUFFERS_CAP];
+  for (u8 i = 0; i < VULKAN_VERTEX_BUFFERS_CAP; i++) {
+    offsets[i] = 0;
+    vertexBuffers[i] = frame->vertexBuffers[i];
+  }
+  if (self->m_gpuCull) {
+    // draw from the compacted copy instead
+    vertexBuffers[1] = frame->culledInstances;
+  }
+  vkCmdBindVertexBuffers(commandBuffer, 0, VULKAN_VERTEX_BUFFERS_CAP, vertexBuffers, offsets);
+  vkCmdBindIndexBuffer(commandBuffer, self->m_indexBuffer, 0, VK_INDEX_TYPE_UINT16);
+
+  VkViewport viewport;
+  viewport.x = (f32)(self->m_viewportX);
+  viewport.y = (f32)(self->m_viewportY);
+  viewport.width = (f32)(self->m_viewportWidth);
+  viewport.height = (f32)(self->m_viewportHeight);
+  viewport.minDepth = 0.0f;
+  viewport.maxDepth = 1.0f;
+  vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+
+  VkRect2D scissor;
+  scissor.offset = (VkOffset2D){0, 0};
+  scissor.extent = self->m_SwapChain__extent;
+  vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+
+  vkCmdBindDescriptorSets(
+      commandBuffer,
+      VK_PIPELINE_BIND_POINT_GRAPHICS,
+      self->m_pipelineLayout,
+      0,
+      1,
+      &frame->descriptorSet,
+      0,
+      NULL);
+
+  if (self->m_gpuCull) {
+    // an indirect draw per batch, each from the start of the batch's span in the compacted copy
+    for (u32 b = 0; 0 == job && b < ctx->batchesCount; b++) {
+      if (ctx->batches[b].pipeline != bound) {
+        bound = ctx->batches[b].pipeline;
+        vkCmdBindPipeline(
+            commandBuffer,
+            VK_PIPELINE_BIND_POINT_GRAPHICS,
+            self->m_graphicsPipelines[bound]);
+      }
+      const VkDeviceSize offset =
+          (VkDeviceSize)ctx->batches[b].firstInstance * self->m_instanceSize;
+      vkCmdBindVertexBuffers(commandBuffer, 1, 1, &frame->culledInstances, &offset);
+      vkCmdDrawIndexedIndirect(
+          commandBuffer,
+          frame->indirectBuffer,
+          b * sizeof(VkDrawIndexedIndirectCommand),
+          1,
+          sizeof(VkDrawIndexedIndirectCommand));
+    }
+  } else {
+    // contiguous shares keep the batches in order across the secondaries
+    const u32 first = (u32)((u64)ctx->batchesCount * job / ctx->jobsCount);
+    const u32 end = (u32)((u64)ctx->batchesCount * (job + 1) / ctx->jobsCount);
+    for (u32 b = first; b < end; b++) {
+      if (ctx->batches[b].pipeline != bound) {
+        bound = ctx->batches[b].pipeline;
+        vkCmdBindPipeline(
+            commandBuffer,
+            VK_PIPELINE_BIND_POINT_GRAPHICS,
+            self->m_graphicsPipelines[bound]);
+      }
+      vkCmdDrawIndexed(
+          commandBuffer,
+          self->m_drawIndexCount,
+          ctx->batches[b].instanceCount,
+          0,
+          0,
+          ctx->batches[b].firstInstance);
+    }
+  }
+
+  ASSERT(VK_SUCCESS == vkEndCommandBuffer(commandBuffer))
+}
+
+/**
+ * Record the draw batches for a frame slot, split over jobsCount jobs.
+ * The slot's secondaries must not be pending.
+ */
+void Vulkan__RecordDrawSecondaries(Vulkan_t* self, u8 frame, u32 jobsCount) {
+  ASSERT(NULL != self->m_jobs)
+  ASSERT(jobsCount > 0 && jobsCount <= self->m_jobs->m_threadsCount)
+
+  const Vulkan__DrawBatch_t all = {0, self->m_instanceCount, VULKAN_PIPELINE_OPAQUE};
+  Vulkan__RecordJob_t ctx;
+  ctx.self = self;
+  ctx.frame = frame;
+  ctx.jobsCount = jobsCount;
+  ctx.batchesCount = self->m_drawBatchesCount > 0 ? self->m_drawBatchesCount : 1;
+  ctx.batches = self->m_drawBatchesCount > 0 ? self->m_drawBatches : &all;
+
+  Jobs__Run(self->m_jobs, jobsCount, RecordDrawJob, &ctx);
+  self->m_frames[frame].drawSecondariesCount = jobsCount;
 }
 
 void Vulkan__CreateSyncObjects(Vulkan_t* self) {
@@ -1593,20 +3357,21 @@ void Vulkan__CreateSyncObjects(Vulkan_t* self) {
   semaphoreInfo.pNext = NULL;
   semaphoreInfo.flags = 0;
 
-  for (u8 i = 0; i < self->m_SwapChain__images_count; i++) {
+  for (u8 i = 0; i < self->m_framesInFlight; i++) {
+    Vulkan__FrameContext_t* frame = &self->m_frames[i];
     ASSERT(
         VK_SUCCESS == vkCreateSemaphore(
                           self->m_logicalDevice,
                           &semaphoreInfo,
                           NULL,
-                          &self->m_imageAvailableSemaphores[i]))
+                          &frame->imageAvailable))
 
     ASSERT(
         VK_SUCCESS == vkCreateSemaphore(
                           self->m_logicalDevice,
                           &semaphoreInfo,
                           NULL,
-                          &self->m_renderFinishedSemaphores[i]))
+                          &frame->renderFinished))
 
     VkFenceCreateInfo fenceInfo;
     fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
@@ -1616,8 +3381,108 @@ void Vulkan__CreateSyncObjects(Vulkan_t* self) {
 
     ASSERT(
         VK_SUCCESS ==
-        vkCreateFence(self->m_logicalDevice, &fenceInfo, NULL, &self->m_inFlightFences[i]))
+        vkCreateFence(self->m_logicalDevice, &fenceInfo, NULL, &frame->inFlight))
+  }
+
+  // timestamps need support from both the device, and the queue family they are written on
+  VkPhysicalDeviceProperties properties;
+  vkGetPhysicalDeviceProperties(self->m_physicalDevice, &properties);
+  u32 queueFamilyCount = 0;
+  vkGetPhysicalDeviceQueueFamilyProperties(self->m_physicalDevice, &queueFamilyCount, NULL);
+  VkQueueFamilyProperties queueFamilies[queueFamilyCount];
+  vkGetPhysicalDeviceQueueFamilyProperties(
+      self->m_physicalDevice,
+      &queueFamilyCount,
+      queueFamilies);
+  const u32 validBits = queueFamilies[self->m_SwapChain__queues.graphics__index].timestampValidBits;
+  self->m_timestamps = properties.limits.timestampComputeAndGraphics && validBits > 0;
+  self->m_timestampPeriod = properties.limits.timestampPeriod;
+  self->m_timestampMask = validBits >= 64 ? UINT64_MAX : ((u64)1 << validBits) - 1;
+  LOG_INFOF(
+      "gpu timestamps %s. period %.3f ns validBits %u",
+      self->m_timestamps ? "enabled" : "unsupported",
+      self->m_timestampPeriod,
+      validBits)
+  if (!self->m_timestamps) {
+    return;
+  }
+
+  VkQueryPoolCreateInfo queryPoolInfo;
+  queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+  queryPoolInfo.pNext = NULL;
+  queryPoolInfo.flags = 0;
+  queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+  queryPoolInfo.queryCount = VULKAN_PASSES_COUNT * 2;
+  queryPoolInfo.pipelineStatistics = 0;
+
+  for (u8 i = 0; i < self->m_framesInFlight; i++) {
+    Vulkan__FrameContext_t* frame = &self->m_frames[i];
+    ASSERT(
+        VK_SUCCESS == vkCreateQueryPool(
+                          self->m_logicalDevice,
+                          &queryPoolInfo,
+                          NULL,
+                          &frame->timestamps))
+    frame->timedPasses = 0;
+  }
+}
+
+const char* Vulkan__PassName(Vulkan__Pass_t pass) {
+  static const char* names[VULKAN_PASSES_COUNT] = {"copy", "cull", "draw"};
+  return names[pass];
+}
+
+/**
+ * Bracket a pass with timestamps in the current frame slot's query pool.
+ * The begin also resets the pair, so command buffers which are resubmitted as-is stay valid.
+ * Neither may be recorded inside a render pass.
+ */
+static void BeginTimestamp(Vulkan_t* self, VkCommandBuffer* commandBuffer, Vulkan__Pass_t pass) {
+  if (!self->m_timestamps) {
+    return;
   }
+  const VkQueryPool pool = self->m_frames[self->m_currentFrame].timestamps;
+  vkCmdResetQueryPool(*commandBuffer, pool, pass * 2, 2);
+  vkCmdWriteTimestamp(*commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, pool, pass * 2);
+}
+
+static void EndTimestamp(Vulkan_t* self, VkCommandBuffer* commandBuffer, Vulkan__Pass_t pass) {
+  if (!self->m_timestamps) {
+    return;
+  }
+  const VkQueryPool pool = self->m_frames[self->m_currentFrame].timestamps;
+  vkCmdWriteTimestamp(*commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, pool, pass * 2 + 1);
+}
+
+/**
+ * Read back the passes a frame slot timed, once its fence has signaled.
+ * Results are already available by then; the query never waits.
+ */
+static void ReadTimestamps(Vulkan_t* self, Vulkan__FrameContext_t* frame) {
+  if (!self->m_timestamps) {
+    return;
+  }
+  for (u8 pass = 0; pass < VULKAN_PASSES_COUNT; pass++) {
+    if (!(frame->timedPasses & (1 << pass))) {
+      self->m_passMs[pass] = 0.0f;  // not run this frame; don't keep counting its last time
+      continue;
+    }
+    u64 ticks[2];
+    const VkResult result = vkGetQueryPoolResults(
+        self->m_logicalDevice,
+        frame->timestamps,
+        pass * 2,
+        2,
+        sizeof(ticks),
+        ticks,
+        sizeof(u64),
+        VK_QUERY_RESULT_64_BIT);
+    if (VK_SUCCESS == result) {
+      const u64 elapsed = (ticks[1] - ticks[0]) & self->m_timestampMask;
+      self->m_passMs[pass] = (f32)((f64)elapsed * self->m_timestampPeriod / 1000000.0);
+    }
+  }
+  frame->timedPasses = 0;
 }
 
 void Vulkan__DeviceWaitIdle(Vulkan_t* self) {
@@ -1625,59 +3490,174 @@ void Vulkan__DeviceWaitIdle(Vulkan_t* self) {
 }
 
 void Vulkan__CleanupSwapChain(Vulkan_t* self) {
-  if (self->m_instance && self->m_logicalDevice && self->m_swapChain) {
+  if (self->m_instance && self->m_logicalDevice && (self->m_swapChain || self->m_headless)) {
     for (u8 i = 0; i < self->m_SwapChain__images_count; i++) {
       vkDestroyFramebuffer(self->m_logicalDevice, self->m_SwapChain__framebuffers[i], NULL);
       vkDestroyImageView(self->m_logicalDevice, self->m_SwapChain__imageViews[i], NULL);
+      if (self->m_headless) {
+        Vulkan__DestroyImage(
+            self,
+            &self->m_SwapChain__images[i],
+            &self->m_SwapChain__imageAllocations[i]);
+      }
+    }
+    self->m_SwapChain__images_count = 0;
+    if (self->m_depthImageView) {
+      vkDestroyImageView(self->m_logicalDevice, self->m_depthImageView, NULL);
+      self->m_depthImageView = VK_NULL_HANDLE;
     }
+    Vulkan__DestroyImage(self, &self->m_depthImage, &self->m_depthImageAllocation);
 
-    vkDestroySwapchainKHR(self->m_logicalDevice, self->m_swapChain, NULL);
+    if (self->m_swapChain) {
+      vkDestroySwapchainKHR(self->m_logicalDevice, self->m_swapChain, NULL);
+      self->m_swapChain = VK_NULL_HANDLE;
+    }
   }
 }
 
+/**
+ * Replace the swapchain, without waiting for the device to idle.
+ * The old one is handed to the driver as oldSwapchain, then retired along with its
+ * image views, framebuffers and depth image, which frames in flight may still render to.
+ */
 void Vulkan__RecreateSwapChain(Vulkan_t* self) {
-  // TODO: the disadvantage of this approach is that we need to stop all rendering before creating
-  // the new swap chain. It is possible to create a new swap chain while drawing commands on an
-  // image from the old swap chain are still in-flight.
+  for (u8 i = 0; i < self->m_SwapChain__images_count; i++) {
+    Vulkan__RetireFramebuffer(self, &self->m_SwapChain__framebuffers[i]);
+    Vulkan__RetireImageView(self, &self->m_SwapChain__imageViews[i]);
+  }
+  Vulkan__RetireImageView(self, &self->m_depthImageView);
+  Vulkan__RetireImage(self, &self->m_depthImage, &self->m_depthImageAllocation);
 
-  Vulkan__DeviceWaitIdle(self);
+  if (self->m_headless) {
+    for (u8 i = 0; i < self->m_SwapChain__images_count; i++) {
+      Vulkan__RetireImage(
+          self,
+          &self->m_SwapChain__images[i],
+          &self->m_SwapChain__imageAllocations[i]);
+    }
+    Vulkan__CreateSwapChain(self, true);
+  } else {
+    // the surface extent limits follow the window
+    ASSERT(
+        VK_SUCCESS == vkGetPhysicalDeviceSurfaceCapabilitiesKHR(
+                          self->m_physicalDevice,
+                          self->m_surface,
+                          &self->m_SwapChain__capabilities))
 
-  Vulkan__CleanupSwapChain(self);
+    const VkSwapchainKHR oldSwapChain = self->m_swapChain;
+    Vulkan__CreateSwapChain(self, true);
+    Retire(self, VULKAN_RETIRED_SWAPCHAIN)->swapChain = oldSwapChain;
+  }
 
-  Vulkan__CreateSwapChain(self, true);
   Vulkan__CreateImageViews(self);
   Vulkan__CreateFrameBuffers(self);
+  // cached draw commands reference the old framebuffers; each slot re-records after its fence
+  Vulkan__InvalidateDrawCommands(self, VULKAN_DIRTY_VIEWPORT);
 }
 
-void Vulkan__AwaitNextFrame(Vulkan_t* self) {
+/**
+ * Wait for the current frame slot, then acquire the next swapchain image.
+ * Returns false when no image could be acquired; the frame should be skipped.
+ */
+bool Vulkan__AwaitNextFrame(Vulkan_t* self) {
+  const u8 frame = self->m_currentFrame;
   ASSERT(
       VK_SUCCESS == vkWaitForFences(
                         self->m_logicalDevice,
                         1,
-                        &self->m_inFlightFences[self->m_currentFrame],
+                        &self->m_frames[frame].inFlight,
                         VK_TRUE,
                         UINT64_MAX))
+  self->m_frames[frame].busy = false;
+  ReadTimestamps(self, &self->m_frames[frame]);
 
-  VkResult result = vkAcquireNextImageKHR(
-      self->m_logicalDevice,
-      self->m_swapChain,
-      UINT64_MAX,
-      self->m_imageAvailableSemaphores[self->m_currentFrame],
-      VK_NULL_HANDLE,
-      &self->m_imageIndex);
-
-  // detect window surface changed (ie. resized, color depth)
-  if (result == VK_ERROR_OUT_OF_DATE_KHR) {
-    // If the swap chain turns out to be out of date when attempting to acquire an image,
-    // then it is no longer possible to present to it.
-    // Therefore we should immediately recreate the swap chain
-    Vulkan__RecreateSwapChain(self);
-    // and try again in the next drawFrame call.
-    return;
+  // this frame's slice of the upload ring is no longer read by the GPU
+  self->m_uploadRingHead = 0;
+
+  // a frame is complete once no slot still waits on it, or on anything before it
+  u64 completed = self->m_frameSerial - 1;
+  for (u8 i = 0; i < self->m_framesInFlight; i++) {
+    if (self->m_frames[i].busy) {
+      completed = MATH_MIN(completed, self->m_frames[i].serial - 1);
+    }
+  }
+  self->m_completedSerial = completed;
+  Vulkan__DestroyRetired(self, completed);
+
+  Vulkan__CollectUploads(self);
+  Vulkan__CollectTextures(self);
+
+  if (self->m_headless) {
+    if (self->m_framebufferResized) {
+      self->m_framebufferResized = false;
+      Vulkan__RecreateSwapChain(self);
+    }
+    // nothing to acquire; the offscreen images are used in turn
+    self->m_imageIndex = (self->m_imageIndex + 1) % self->m_SwapChain__images_count;
+    return true;
+  }
+
+  // at most two tries: once as is, and once more with a freshly recreated swapchain
+  for (u8 attempt = 0; attempt < 2; attempt++) {
+    // every resize since the last frame collapses into this one recreation
+    if (self->m_framebufferResized) {
+      self->m_framebufferResized = false;
+      Vulkan__RecreateSwapChain(self);
+    }
+
+    VkResult result = vkAcquireNextImageKHR(
+        self->m_logicalDevice,
+        self->m_swapChain,
+        UINT64_MAX,
+        self->m_frames[frame].imageAvailable,
+        VK_NULL_HANDLE,
+        &self->m_imageIndex);
+
+    // detect window surface changed (ie. resized, color depth)
+    if (result == VK_ERROR_OUT_OF_DATE_KHR) {
+      // it is no longer possible to present to this swap chain
+      self->m_framebufferResized = true;
+      continue;
+    }
+    if (result == VK_SUBOPTIMAL_KHR) {
+      // still presentable; recreate before the next frame
+      self->m_framebufferResized = true;
+      return true;
+    }
+    ASSERT_CONTEXT(result == VK_SUCCESS, "vkAcquireNextImageKHR failed.")
+    return true;
+  }
+  return false;
+}
+
+/**
+ * Record the work which changes every frame: pending uploads, then culling.
+ */
+void Vulkan__RecordFrameCommands(Vulkan_t* self, VkCommandBuffer* commandBuffer) {
+  VkCommandBufferBeginInfo beginInfo;
+  beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+  beginInfo.pNext = NULL;
+  beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+  beginInfo.pInheritanceInfo = NULL;
+
+  ASSERT(VK_SUCCESS == vkBeginCommandBuffer(*commandBuffer, &beginInfo))
+
+  BeginTimestamp(self, commandBuffer, VULKAN_PASS_COPY);
+  Vulkan__RecordPendingCopies(self, commandBuffer);
+  EndTimestamp(self, commandBuffer, VULKAN_PASS_COPY);
+  if (self->m_gpuCull) {
+    BeginTimestamp(self, commandBuffer, VULKAN_PASS_CULL);
+    Vulkan__RecordCull(self, commandBuffer);
+    EndTimestamp(self, commandBuffer, VULKAN_PASS_CULL);
   }
-  ASSERT_CONTEXT(result == VK_SUCCESS, "vkAcquireNextImageKHR failed.")
+
+  ASSERT(VK_SUCCESS == vkEndCommandBuffer(*commandBuffer))
 }
 
+/**
+ * Record the render pass for one swapchain image, executing the frame slot's secondaries.
+ * Reads nothing that changes per frame, except through buffers; see VULKAN_DIRTY_*.
+ */
 void Vulkan__RecordCommandBuffer(Vulkan_t* self, VkCommandBuffer* commandBuffer, u32 imageIndex) {
   VkCommandBufferBeginInfo beginInfo;
   beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
@@ -1694,81 +3674,117 @@ void Vulkan__RecordCommandBuffer(Vulkan_t* self, VkCommandBuffer* commandBuffer,
   renderPassInfo.framebuffer = self->m_SwapChain__framebuffers[imageIndex];
   renderPassInfo.renderArea.offset = (VkOffset2D){0, 0};
   renderPassInfo.renderArea.extent = self->m_SwapChain__extent;
-  VkClearValue clearColor = {{{0.0f, 0.0f, 0.0f, 1.0f}}};
-  renderPassInfo.clearValueCount = 1;
-  renderPassInfo.pClearValues = &clearColor;
-  vkCmdBeginRenderPass(*commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
-  vkCmdBindPipeline(*commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, self->m_graphicsPipeline);
-
-  VkDeviceSize offsets[self->m_SwapChain__images_count];
-  for (u8 i = 0; i < self->m_SwapChain__images_count; i++) {
-    offsets[i] = 0;
-  }
-  vkCmdBindVertexBuffers(
-      *commandBuffer,
-      0,
-      self->m_SwapChain__images_count,
-      self->m_vertexBuffers,
-      offsets);
-  vkCmdBindIndexBuffer(*commandBuffer, self->m_indexBuffer, 0, VK_INDEX_TYPE_UINT16);
-
-  VkViewport viewport;
-  viewport.x = (f32)(self->m_viewportX);
-  viewport.y = (f32)(self->m_viewportY);
-  viewport.width = (f32)(self->m_viewportWidth);
-  viewport.height = (f32)(self->m_viewportHeight);
-  viewport.minDepth = 0.0f;
-  viewport.maxDepth = 1.0f;
-  vkCmdSetViewport(*commandBuffer, 0, 1, &viewport);
-
-  VkRect2D scissor;
-  scissor.offset = (VkOffset2D){0, 0};
-  scissor.extent = self->m_SwapChain__extent;
-  vkCmdSetScissor(*commandBuffer, 0, 1, &scissor);
-
-  vkCmdBindDescriptorSets(
+  // per attachment: color, then depth; 1.0 is the far plane
+  VkClearValue clearValues[2];
+  clearValues[0].color = (VkClearColorValue){{0.0f, 0.0f, 0.0f, 1.0f}};
+  clearValues[1].depthStencil = (VkClearDepthStencilValue){1.0f, 0};
+  renderPassInfo.clearValueCount = ARRAY_COUNT(clearValues);
+  renderPassInfo.pClearValues = clearValues;
+  BeginTimestamp(self, commandBuffer, VULKAN_PASS_DRAW);
+  vkCmdBeginRenderPass(
       *commandBuffer,
-      VK_PIPELINE_BIND_POINT_GRAPHICS,
-      self->m_pipelineLayout,
-      0,
-      1,
-      &self->m_descriptorSets[self->m_currentFrame],
-      0,
-      NULL);
+      &renderPassInfo,
+      VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
 
-  vkCmdDrawIndexed(*commandBuffer, self->m_drawIndexCount, self->m_instanceCount, 0, 0, 0);
+  const Vulkan__FrameContext_t* frame = &self->m_frames[self->m_currentFrame];
+  vkCmdExecuteCommands(*commandBuffer, frame->drawSecondariesCount, frame->drawSecondaries);
 
   vkCmdEndRenderPass(*commandBuffer);
+  EndTimestamp(self, commandBuffer, VULKAN_PASS_DRAW);
 
   ASSERT(VK_SUCCESS == vkEndCommandBuffer(*commandBuffer))
 }
 
 void Vulkan__DrawFrame(Vulkan_t* self) {
+  Vulkan__FrameContext_t* frame = &self->m_frames[self->m_currentFrame];
+
   // NOTICE: Fence will deadlock if waiting on an empty work queue.
   // Therefore, we only reset the fence just prior to submitting work.
-  vkResetFences(self->m_logicalDevice, 1, &self->m_inFlightFences[self->m_currentFrame]);
+  vkResetFences(self->m_logicalDevice, 1, &frame->inFlight);
+
+  u32 commandBuffersCount = 0;
+  VkCommandBuffer commandBuffers[2];
+
+  // on idle frames there is nothing to copy, and this is skipped
+  if (self->m_pendingCopiesCount > 0 || self->m_gpuCull || NeedsCatchUp(self)) {
+    ASSERT(VK_SUCCESS == vkResetCommandBuffer(frame->commandBuffer, 0))
+    Vulkan__RecordFrameCommands(self, &frame->commandBuffer);
+    commandBuffers[commandBuffersCount++] = frame->commandBuffer;
+    frame->timedPasses |= 1 << VULKAN_PASS_COPY;
+    if (self->m_gpuCull) {
+      frame->timedPasses |= 1 << VULKAN_PASS_CULL;
+    }
+  }
 
-  ASSERT(VK_SUCCESS == vkResetCommandBuffer(self->m_commandBuffers[self->m_currentFrame], 0))
+  if (self->m_drawDirty) {
+    self->m_drawDirty = 0;
+    for (u8 f = 0; f < self->m_framesInFlight; f++) {
+      self->m_frames[f].drawSecondariesStale = true;
+      for (u8 i = 0; i < VULKAN_SWAPCHAIN_IMAGES_CAP; i++) {
+        self->m_frames[f].drawCommandsStale[i] = true;
+      }
+    }
+  }
+  // the set is only rewritten now that this slot's fence has signaled; no submitted frame reads it.
+  // the texture array is update-after-bind, so the recorded draw commands stay valid
+  if (frame->textureDescriptorsStale) {
+    frame->textureDescriptorsStale = false;
+    WriteTextureDescriptors(self, frame->descriptorSet);
+  }
 
-  Vulkan__RecordCommandBuffer(
-      self,
-      &self->m_commandBuffers[self->m_currentFrame],
-      self->m_imageIndex);
+  // after the frame commands, which may have regrown the buffers bound for drawing;
+  // only this frame slot's fence is known to have signaled, so only its buffers are re-recorded
+  if (frame->drawSecondariesStale) {
+    frame->drawSecondariesStale = false;
+    // no more jobs than batches; culling on the GPU draws every batch from one job
+    const u32 batchesCount = self->m_gpuCull ? 1 : MATH_MAX(self->m_drawBatchesCount, 1);
+    Vulkan__RecordDrawSecondaries(
+        self,
+        self->m_currentFrame,
+        MATH_MIN(self->m_jobs->m_threadsCount, batchesCount));
+    // re-recording invalidated every primary which executes them
+    for (u8 i = 0; i < VULKAN_SWAPCHAIN_IMAGES_CAP; i++) {
+      frame->drawCommandsStale[i] = true;
+    }
+  }
+  VkCommandBuffer* draw = &frame->drawCommandBuffers[self->m_imageIndex];
+  if (frame->drawCommandsStale[self->m_imageIndex]) {
+    frame->drawCommandsStale[self->m_imageIndex] = false;
+    ASSERT(VK_SUCCESS == vkResetCommandBuffer(*draw, 0))
+    Vulkan__RecordCommandBuffer(self, draw, self->m_imageIndex);
+  }
+  commandBuffers[commandBuffersCount++] = *draw;
+  frame->timedPasses |= 1 << VULKAN_PASS_DRAW;
 
   VkSubmitInfo submitInfo;
   submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
   submitInfo.pNext = NULL;
 
-  VkSemaphore waitSemaphores[] = {self->m_imageAvailableSemaphores[self->m_currentFrame]};
-  VkPipelineStageFlags waitStages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
-  submitInfo.waitSemaphoreCount = 1;
+  u32 waitCount = 0;
+  VkSemaphore waitSemaphores[1 + VULKAN_UPLOAD_BATCHES_CAP];
+  VkPipelineStageFlags waitStages[1 + VULKAN_UPLOAD_BATCHES_CAP];
+  if (!self->m_headless) {
+    waitSemaphores[waitCount] = frame->imageAvailable;
+    waitStages[waitCount] = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    waitCount++;
+  }
+  // make any uploads submitted since the last frame visible to this one
+  for (u8 i = 0; i < VULKAN_UPLOAD_BATCHES_CAP; i++) {
+    if (self->m_uploadBatches[i].waitPending) {
+      self->m_uploadBatches[i].waitPending = false;
+      waitSemaphores[waitCount] = self->m_uploadBatches[i].semaphore;
+      waitStages[waitCount] = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+      waitCount++;
+    }
+  }
+  submitInfo.waitSemaphoreCount = waitCount;
   submitInfo.pWaitSemaphores = waitSemaphores;
   submitInfo.pWaitDstStageMask = waitStages;
-  submitInfo.commandBufferCount = 1;
-  submitInfo.pCommandBuffers = &self->m_commandBuffers[self->m_currentFrame];
+  submitInfo.commandBufferCount = commandBuffersCount;
+  submitInfo.pCommandBuffers = commandBuffers;
 
-  VkSemaphore signalSemaphores[] = {self->m_renderFinishedSemaphores[self->m_currentFrame]};
-  submitInfo.signalSemaphoreCount = 1;
+  VkSemaphore signalSemaphores[] = {frame->renderFinished};
+  submitInfo.signalSemaphoreCount = self->m_headless ? 0 : 1;
   submitInfo.pSignalSemaphores = signalSemaphores;
 
   ASSERT(
@@ -1776,7 +3792,14 @@ void Vulkan__DrawFrame(Vulkan_t* self) {
                         self->m_SwapChain__queues.graphics__queue,
                         1,
                         &submitInfo,
-                        self->m_inFlightFences[self->m_currentFrame]))
+                        frame->inFlight))
+  frame->serial = self->m_frameSerial++;
+  frame->busy = true;
+
+  if (self->m_headless) {
+    self->m_currentFrame = (self->m_currentFrame + 1) % self->m_framesInFlight;
+    return;
+  }
 
   VkPresentInfoKHR presentInfo;
   presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
@@ -1797,14 +3820,10 @@ void Vulkan__DrawFrame(Vulkan_t* self) {
     queue = self->m_SwapChain__queues.present__queue;
   }
 
+  // recreation is left to the next Vulkan__AwaitNextFrame(), so bursts of resizes coalesce
   VkResult result2 = vkQueuePresentKHR(queue, &presentInfo);
-  if (self->m_framebufferResized) {
-    self->m_framebufferResized = false;
-    Vulkan__RecreateSwapChain(self);
-  } else if (result2 == VK_ERROR_OUT_OF_DATE_KHR) {
-    Vulkan__RecreateSwapChain(self);
-  } else if (result2 == VK_SUBOPTIMAL_KHR) {
-    Vulkan__RecreateSwapChain(self);
+  if (result2 == VK_ERROR_OUT_OF_DATE_KHR || result2 == VK_SUBOPTIMAL_KHR) {
+    self->m_framebufferResized = true;
   } else if (result2 != VK_SUCCESS) {
     ASSERT_CONTEXT(
         result2 == VK_SUCCESS,
@@ -1812,7 +3831,7 @@ void Vulkan__DrawFrame(Vulkan_t* self) {
         self->m_SwapChain__queues.same)
   }
 
-  self->m_currentFrame = (self->m_currentFrame + 1) % self->m_SwapChain__images_count;
+  self->m_currentFrame = (self->m_currentFrame + 1) % self->m_framesInFlight;
 }
 
 void Vulkan__Cleanup(Vulkan_t* self) {
@@ -1822,41 +3841,84 @@ void Vulkan__Cleanup(Vulkan_t* self) {
     if (self->m_logicalDevice) {
       Vulkan__CleanupSwapChain(self);
 
-      vkDestroySampler(self->m_logicalDevice, self->m_textureSampler, NULL);
-      vkDestroyImageView(self->m_logicalDevice, self->m_textureImageView, NULL);
-
-      vkDestroyImage(self->m_logicalDevice, self->m_textureImage, NULL);
-      vkFreeMemory(self->m_logicalDevice, self->m_textureImageMemory, NULL);
+      for (u8 i = 0; i < VULKAN_TEXTURE_FILTERS_COUNT; i++) {
+        vkDestroySampler(self->m_logicalDevice, self->m_textureSamplers[i], NULL);
+      }
+      for (u32 i = 0; i < self->m_texturesCap; i++) {
+        Vulkan__Texture_t* texture = &self->m_textures[i];
+        if (texture->image) {
+          vkDestroyImageView(self->m_logicalDevice, texture->imageView, NULL);
+          Vulkan__DestroyImage(self, &texture->image, &texture->allocation);
+        }
+      }
+      free(self->m_textures);
+      free(self->m_textureInfos);
+      self->m_textures = NULL;
+      self->m_textureInfos = NULL;
+      self->m_texturesCap = 0;
+      if (self->m_placeholderTexture.image) {
+        vkDestroyImageView(self->m_logicalDevice, self->m_placeholderTexture.imageView, NULL);
+        Vulkan__DestroyImage(
+            self,
+            &self->m_placeholderTexture.image,
+            &self->m_placeholderTexture.allocation);
+      }
 
       if (self->m_descriptorPool) {
         vkDestroyDescriptorPool(self->m_logicalDevice, self->m_descriptorPool, NULL);
       }
 
-      for (u8 i = 0; i < self->m_SwapChain__images_count; i++) {
-        vkDestroyBuffer(self->m_logicalDevice, self->m_uniformBuffers[i], NULL);
-        vkFreeMemory(self->m_logicalDevice, self->m_uniformBuffersMemory[i], NULL);
+      for (u8 i = 0; i < self->m_framesInFlight; i++) {
+        Vulkan__DestroyBuffer(
+            self,
+            &self->m_frames[i].uniformBuffer,
+            &self->m_frames[i].uniformBufferAllocation);
       }
 
       if (self->m_descriptorSetLayout) {
         vkDestroyDescriptorSetLayout(self->m_logicalDevice, self->m_descriptorSetLayout, NULL);
       }
 
-      if (self->m_indexBuffer) {
-        vkDestroyBuffer(self->m_logicalDevice, self->m_indexBuffer, NULL);
+      Vulkan__DestroyBuffer(self, &self->m_indexBuffer, &self->m_indexBufferAllocation);
+      Vulkan__DestroyBuffer(self, &self->m_atlasBuffer, &self->m_atlasBufferAllocation);
+      Vulkan__DestroyBuffer(self, &self->m_uploadRing, &self->m_uploadRingAllocation);
+      // the device is idle; nothing retired can still be in use
+      Vulkan__DestroyRetired(self, UINT64_MAX);
+      for (u8 f = 0; f < self->m_framesInFlight; f++) {
+        Vulkan__FrameContext_t* frame = &self->m_frames[f];
+        for (u8 i = 0; i < VULKAN_VERTEX_BUFFERS_CAP; i++) {
+          Vulkan__DestroyBuffer(
+              self,
+              &frame->vertexBuffers[i],
+              &frame->vertexBufferAllocations[i]);
+        }
+
+        Vulkan__DestroyBuffer(self, &frame->culledInstances, &frame->culledInstancesAllocation);
+        Vulkan__DestroyBuffer(self, &frame->cullGroups, &frame->cullGroupsAllocation);
+        Vulkan__DestroyBuffer(self, &frame->indirectBuffer, &frame->indirectBufferAllocation);
       }
-      if (self->m_indexBufferMemory) {
-        vkFreeMemory(self->m_logicalDevice, self->m_indexBufferMemory, NULL);
+      if (self->m_cullPipeline) {
+        vkDestroyPipeline(self->m_logicalDevice, self->m_cullPipeline, NULL);
       }
-
-      for (u8 i = 0; i < self->m_SwapChain__images_count; i++) {
-        vkDestroyBuffer(self->m_logicalDevice, self->m_vertexBuffers[i], NULL);
+      if (self->m_cullPipelineLayout) {
+        vkDestroyPipelineLayout(self->m_logicalDevice, self->m_cullPipelineLayout, NULL);
+      }
+      if (self->m_cullDescriptorPool) {
+        vkDestroyDescriptorPool(self->m_logicalDevice, self->m_cullDescriptorPool, NULL);
+      }
+      if (self->m_cullDescriptorSetLayout) {
+        vkDestroyDescriptorSetLayout(self->m_logicalDevice, self->m_cullDescriptorSetLayout, NULL);
       }
-      for (u8 i = 0; i < self->m_SwapChain__images_count; i++) {
-        vkFreeMemory(self->m_logicalDevice, self->m_vertexBufferMemories[i], NULL);
+
+      if (self->m_pipelineCache) {
+        Vulkan__SavePipelineCache(self);
+        vkDestroyPipelineCache(self->m_logicalDevice, self->m_pipelineCache, NULL);
       }
 
-      if (self->m_graphicsPipeline) {
-        vkDestroyPipeline(self->m_logicalDevice, self->m_graphicsPipeline, NULL);
+      for (u8 p = 0; p < VULKAN_PIPELINES_COUNT; p++) {
+        if (self->m_graphicsPipelines[p]) {
+          vkDestroyPipeline(self->m_logicalDevice, self->m_graphicsPipelines[p], NULL);
+        }
       }
       if (self->m_pipelineLayout) {
         vkDestroyPipelineLayout(self->m_logicalDevice, self->m_pipelineLayout, NULL);
@@ -1865,20 +3927,48 @@ void Vulkan__Cleanup(Vulkan_t* self) {
         vkDestroyRenderPass(self->m_logicalDevice, self->m_renderPass, NULL);
       }
 
-      for (u8 i = 0; i < self->m_SwapChain__images_count; i++) {
-        if (self->m_renderFinishedSemaphores[i]) {
-          vkDestroySemaphore(self->m_logicalDevice, self->m_renderFinishedSemaphores[i], NULL);
+      for (u8 i = 0; i < self->m_framesInFlight; i++) {
+        Vulkan__FrameContext_t* frame = &self->m_frames[i];
+        if (frame->renderFinished) {
+          vkDestroySemaphore(self->m_logicalDevice, frame->renderFinished, NULL);
         }
-        if (self->m_imageAvailableSemaphores[i]) {
-          vkDestroySemaphore(self->m_logicalDevice, self->m_imageAvailableSemaphores[i], NULL);
+        if (frame->imageAvailable) {
+          vkDestroySemaphore(self->m_logicalDevice, frame->imageAvailable, NULL);
         }
-        if (self->m_inFlightFences[i]) {
-          vkDestroyFence(self->m_logicalDevice, self->m_inFlightFences[i], NULL);
+        if (frame->inFlight) {
+          vkDestroyFence(self->m_logicalDevice, frame->inFlight, NULL);
+        }
+        if (frame->timestamps) {
+          vkDestroyQueryPool(self->m_logicalDevice, frame->timestamps, NULL);
         }
       }
       if (self->m_commandPool) {
         vkDestroyCommandPool(self->m_logicalDevice, self->m_commandPool, NULL);
       }
+      for (u32 t = 0; t < JOBS_THREADS_CAP; t++) {
+        if (self->m_recordPools[t]) {
+          vkDestroyCommandPool(self->m_logicalDevice, self->m_recordPools[t], NULL);
+        }
+      }
+
+      for (u8 i = 0; i < VULKAN_UPLOAD_BATCHES_CAP; i++) {
+        Vulkan__UploadBatch_t* batch = &self->m_uploadBatches[i];
+        for (u32 i2 = 0; i2 < batch->stagingCount; i2++) {
+          Vulkan__DestroyBuffer(self, &batch->stagingBuffers[i2], &batch->stagingAllocations[i2]);
+        }
+        if (batch->fence) {
+          vkDestroyFence(self->m_logicalDevice, batch->fence, NULL);
+        }
+        if (batch->semaphore) {
+          vkDestroySemaphore(self->m_logicalDevice, batch->semaphore, NULL);
+        }
+      }
+      if (self->m_uploadCommandPool) {
+        vkDestroyCommandPool(self->m_logicalDevice, self->m_uploadCommandPool, NULL);
+      }
+
+      Allocator__LogStats(&self->m_allocator);
+      Allocator__Shutdown(&self->m_allocator);
 
       vkDestroyDevice(self->m_logicalDevice, NULL);
 
@@ -4,7 +4,9 @@
 #define VK_NO_PROTOTYPES
 #include <volk.h>
 
+#include "Allocator.h"
 #include "Base.h"
+#include "Jobs.h"
 
 #define DEBUG_VULKAN
 
@@ -19,8 +21,132 @@
 #define VULKAN_SWAPCHAIN_FORMATS_CAP 10
 #define VULKAN_SWAPCHAIN_PRESENT_MODES_CAP 10
 #define VULKAN_SWAPCHAIN_IMAGES_CAP 3
+#define VULKAN_FRAMES_IN_FLIGHT_CAP 4
+#define VULKAN_FRAMES_IN_FLIGHT_DEFAULT 2
 #define VULKAN_SHADER_FILE_BUFFER_BYTES_CAP 50 * 1024  // KB
 #define VULKAN_VERTEX_BUFFERS_CAP 2
+#define VULKAN_UPLOAD_RING_FRAME_BYTES 1 * 1024 * 1024  // MB
+#define VULKAN_UPLOAD_RING_ALIGNMENT 16
+#define VULKAN_PENDING_COPIES_CAP 64
+#define VULKAN_RETIRED_CAP 256
+#define VULKAN_MISSED_COPIES_CAP 64
+#define VULKAN_CULL_GROUP_SIZE 256  // must match GROUP_SIZE in cull.comp
+#define VULKAN_CULL_DRAWS_CAP 8  // draw batches culled on the GPU, each drawn indirectly
+#define VULKAN_PIPELINE_CACHE_MAGIC 0x48435050  // "PPCH"
+#define VULKAN_PIPELINE_CACHE_DATA_CAP 16 * 1024 * 1024  // MB
+#define VULKAN_UPLOAD_BATCHES_CAP 4
+#define VULKAN_UPLOAD_STAGING_CAP 32
+#define VULKAN_DRAW_BATCHES_CAP 4096
+#define VULKAN_TEXTURES_MIN_CAP 16
+#define VULKAN_TEXTURES_MAX 4096  // upper bound on the bindless table; the device may allow fewer
+#define VULKAN_TEXTURE_MIPS_CAP 16
+
+// reasons to re-record the cached draw commands; raised via Vulkan__InvalidateDrawCommands()
+#define VULKAN_DIRTY_VIEWPORT (1 << 0)        // viewport, scissor or framebuffers
+#define VULKAN_DIRTY_INSTANCE_COUNT (1 << 1)  // draw arguments
+#define VULKAN_DIRTY_PIPELINE (1 << 2)
+#define VULKAN_DIRTY_DESCRIPTORS (1 << 3)  // descriptor sets, or the buffers bound for drawing
+
+// the spans of GPU work timed by the profiler; see m_passMs
+typedef enum {
+  VULKAN_PASS_COPY,  // pending uploads and catch-up copies
+  VULKAN_PASS_CULL,
+  VULKAN_PASS_DRAW,  // the render pass
+  VULKAN_PASSES_COUNT,
+} Vulkan__Pass_t;
+
+// the sprite pipelines; both test depth against one attachment, cleared every frame
+typedef enum {
+  // alpha-tested, unblended; writes depth. drawn first, front-to-back, so covered pixels are
+  // rejected before they are shaded
+  VULKAN_PIPELINE_OPAQUE,
+  // alpha-blended; tests depth without writing it. drawn after, back-to-front
+  VULKAN_PIPELINE_BLENDED,
+  VULKAN_PIPELINES_COUNT,
+} Vulkan__Pipeline_t;
+
+// a contiguous run of instances, drawn with one call; batches are drawn in order
+typedef struct {
+  u32 firstInstance;
+  u32 instanceCount;
+  Vulkan__Pipeline_t pipeline;
+} Vulkan__DrawBatch_t;
+
+// A frame context is everything one frame in flight writes, or the GPU reads for it
+// slots are used round-robin, and a slot is only touched again once its fence has signaled,
+// so the CPU fills one slot while the GPU still draws from the others.
+// - each slot has its own copy of every vertex buffer; updates land in the current slot only
+// - a slot catches up on the ranges it missed while in flight, copying them from the previous
+//   slot on the GPU; the previous slot always holds the newest contents
+typedef struct {
+  VkFence inFlight;
+  VkSemaphore imageAvailable;
+  VkSemaphore renderFinished;
+  VkCommandBuffer commandBuffer;  // copies and culling
+
+  VkBuffer uniformBuffer;
+  Allocation_t uniformBufferAllocation;
+  void* uniformBufferMapped;
+  VkDescriptorSet descriptorSet;
+
+  VkBuffer vertexBuffers[VULKAN_VERTEX_BUFFERS_CAP];
+  Allocation_t vertexBufferAllocations[VULKAN_VERTEX_BUFFERS_CAP];
+  VkDeviceSize vertexBufferSizes[VULKAN_VERTEX_BUFFERS_CAP];
+  u32 missedCount[VULKAN_VERTEX_BUFFERS_CAP];
+  VkBufferCopy missed[VULKAN_VERTEX_BUFFERS_CAP][VULKAN_MISSED_COPIES_CAP];
+  bool missedAll[VULKAN_VERTEX_BUFFERS_CAP];  // too many ranges, or the slot was regrown
+
+  VkDescriptorSet cullDescriptorSet;
+  bool cullDescriptorsStale;
+  VkBuffer culledInstances;
+  Allocation_t culledInstancesAllocation;
+  VkDeviceSize culledInstancesSize;
+  VkBuffer cullGroups;
+  Allocation_t cullGroupsAllocation;
+  VkBuffer indirectBuffer;  // a VkDrawIndexedIndirectCommand per draw batch
+  Allocation_t indirectBufferAllocation;
+
+  // draw commands, recorded once per swapchain image, then resubmitted as-is;
+  // per-frame data reaches them through buffers, so only the VULKAN_DIRTY_* events re-record
+  VkCommandBuffer drawCommandBuffers[VULKAN_SWAPCHAIN_IMAGES_CAP];
+  bool drawCommandsStale[VULKAN_SWAPCHAIN_IMAGES_CAP];
+  // the batches they execute, recorded in parallel; one per job, from the job's own pool
+  VkCommandBuffer drawSecondaries[JOBS_THREADS_CAP];
+  u32 drawSecondariesCount;
+  bool drawSecondariesStale;
+  bool textureDescriptorsStale;  // a texture became resident, or was replaced
+
+  u64 serial;  // of the frame last submitted from this slot
+  bool busy;   // submitted, and its fence not yet waited on
+
+  // a begin and end timestamp per Vulkan__Pass_t
+  VkQueryPool timestamps;
+  u32 timedPasses;  // bit per pass written by the last submit, and not yet read back
+} Vulkan__FrameContext_t;
+
+typedef enum {
+  VULKAN_RETIRED_BUFFER,
+  VULKAN_RETIRED_IMAGE,
+  VULKAN_RETIRED_IMAGE_VIEW,
+  VULKAN_RETIRED_FRAMEBUFFER,
+  VULKAN_RETIRED_SWAPCHAIN,
+  VULKAN_RETIRED_DESCRIPTOR_POOL,
+} Vulkan__RetiredType_t;
+
+// a handle the GPU may still use, and the frame serial after which it no longer can
+typedef struct {
+  Vulkan__RetiredType_t type;
+  u64 serial;
+  union {
+    VkBuffer buffer;
+    VkImage image;
+    VkImageView imageView;
+    VkFramebuffer framebuffer;
+    VkSwapchainKHR swapChain;
+    VkDescriptorPool descriptorPool;
+  };
+  Allocation_t allocation;  // buffers and images only
+} Vulkan__Retired_t;
 
 typedef struct {
   bool same;
@@ -30,8 +156,66 @@ typedef struct {
   bool present_found;
   u32 present__index;
   VkQueue present__queue;
+  // true only for a dedicated (non-graphics) transfer family;
+  // otherwise transfer__index and transfer__queue alias graphics
+  bool transfer_found;
+  u32 transfer__index;
+  VkQueue transfer__queue;
 } Vulkan__PhysicalDeviceQueue_t;
 
+// monotonic; an upload is complete once Vulkan__IsUploadComplete() says so
+typedef u64 Vulkan__UploadTicket_t;
+
+// how a texture is filtered; selects its sampler
+typedef enum {
+  VULKAN_TEXTURE_FILTER_PIXEL_ART,  // nearest texel within a level, blended between levels
+  VULKAN_TEXTURE_FILTER_SMOOTH,     // trilinear
+  VULKAN_TEXTURE_FILTERS_COUNT,
+} Vulkan__TextureFilter_t;
+
+// a sampled image, addressed by its index (handle) in m_textures
+// its upload is queued without waiting; until that completes, the placeholder is bound instead.
+// - the handle is also its element in the bindless texture array; instances select it by index
+typedef struct {
+  bool used;
+  bool resident;
+  Vulkan__UploadTicket_t ticket;  // of the pending upload, while not resident
+  u32 width;
+  u32 height;
+  u32 mipsCount;
+  Vulkan__TextureFilter_t filter;
+  VkImage image;
+  Allocation_t allocation;
+  VkImageView imageView;
+} Vulkan__Texture_t;
+
+typedef struct {
+  VkCommandBuffer commandBuffer;
+  VkFence fence;
+  // waited on by the next graphics submit, which makes the uploaded data visible
+  VkSemaphore semaphore;
+  Vulkan__UploadTicket_t ticket;
+  bool recording;
+  bool submitted;
+  bool waitPending;
+  u32 stagingCount;
+  VkBuffer stagingBuffers[VULKAN_UPLOAD_STAGING_CAP];
+  Allocation_t stagingAllocations[VULKAN_UPLOAD_STAGING_CAP];
+} Vulkan__UploadBatch_t;
+
+// prepended to the driver's pipeline cache data on disk;
+// the file is only trusted when every field matches the running device and shaders
+typedef struct {
+  u32 magic;
+  u32 headerSize;
+  u32 vendorID;
+  u32 deviceID;
+  u32 driverVersion;
+  u8 pipelineCacheUUID[VK_UUID_SIZE];
+  u64 shaderHash;
+  u64 dataSize;
+} Vulkan__PipelineCacheHeader_t;
+
 typedef struct {
   unsigned int m_requiredDriverExtensionsCount;
   const char* m_requiredDriverExtensions[VULKAN_REQUIRED_DRIVER_EXTENSIONS_CAP];
@@ -45,6 +229,7 @@ typedef struct {
   VkPhysicalDevice m_physicalDevice;
   VkSurfaceKHR m_surface;
   VkDevice m_logicalDevice;
+  Allocator_t m_allocator;
 
   // window
   f32 m_aspectRatio;
@@ -64,6 +249,9 @@ typedef struct {
   bool m_framebufferResized;
   bool m_minimized;
   bool m_maximized;
+  // no surface or swapchain; frames render into a ring of offscreen images instead,
+  // which stand in for the swapchain images below and are left in TRANSFER_SRC_OPTIMAL
+  bool m_headless;
 
   // swapchain
   VkSwapchainKHR m_swapChain;
@@ -71,6 +259,7 @@ typedef struct {
   u32 m_SwapChain__images_count;
   VkImage m_SwapChain__images[VULKAN_SWAPCHAIN_IMAGES_CAP];
   VkImageView m_SwapChain__imageViews[VULKAN_SWAPCHAIN_IMAGES_CAP];
+  Allocation_t m_SwapChain__imageAllocations[VULKAN_SWAPCHAIN_IMAGES_CAP];  // headless only
   VkFormat m_SwapChain__imageFormat;
   VkExtent2D m_SwapChain__extent;
   u32 m_SwapChain__formats_count;
@@ -79,35 +268,108 @@ typedef struct {
   VkPresentModeKHR m_SwapChain__presentModes[VULKAN_SWAPCHAIN_PRESENT_MODES_CAP];
   Vulkan__PhysicalDeviceQueue_t m_SwapChain__queues;
   VkFramebuffer m_SwapChain__framebuffers[VULKAN_SWAPCHAIN_IMAGES_CAP];
+  // one depth attachment, shared by every framebuffer; the render pass orders its frames
+  VkFormat m_depthFormat;
+  VkImage m_depthImage;
+  Allocation_t m_depthImageAllocation;
+  VkImageView m_depthImageView;
+
+  // frames in flight; independent of how many images the swapchain has
+  u8 m_framesInFlight;
   u8 m_currentFrame;
+  Vulkan__FrameContext_t m_frames[VULKAN_FRAMES_IN_FLIGHT_CAP];
   u32 m_imageIndex;
   u32 m_drawIndexCount;
   u32 m_instanceCount;
+  u32 m_instanceSize;  // stride of the instance vertex buffer
 
   // pipeline
   VkRenderPass m_renderPass;
   VkDescriptorSetLayout m_descriptorSetLayout;
-  VkBuffer m_vertexBuffers[VULKAN_VERTEX_BUFFERS_CAP];
-  VkDeviceMemory m_vertexBufferMemories[VULKAN_VERTEX_BUFFERS_CAP];
+  VkDeviceSize m_vertexBufferSizes[VULKAN_VERTEX_BUFFERS_CAP];  // each slot grows to match
   VkPipelineLayout m_pipelineLayout;
-  VkPipeline m_graphicsPipeline;
+  VkPipeline m_graphicsPipelines[VULKAN_PIPELINES_COUNT];
   VkCommandPool m_commandPool;
-  VkImage m_textureImage;
-  VkDeviceMemory m_textureImageMemory;
-  VkImageView m_textureImageView;
-  VkSampler m_textureSampler;
+  Vulkan__Texture_t m_placeholderTexture;
+  // bindless texture table; one partially bound, update-after-bind array per descriptor set.
+  // sets are allocated with m_texturesCap elements, and reallocated when the table grows.
+  Vulkan__Texture_t* m_textures;
+  u32 m_texturesCap;
+  u32 m_texturesMax;  // the layout's array size; VULKAN_TEXTURES_MAX, clamped to the device
+  VkDescriptorImageInfo* m_textureInfos;  // scratch for writing the array; m_texturesCap long
+  VkSampler m_textureSamplers[VULKAN_TEXTURE_FILTERS_COUNT];
   VkBuffer m_indexBuffer;
-  VkDeviceMemory m_indexBufferMemory;
-  VkBuffer m_uniformBuffers[VULKAN_SWAPCHAIN_IMAGES_CAP];
-  u32 m_uniformBufferLengths[VULKAN_SWAPCHAIN_IMAGES_CAP];
-  VkDeviceMemory m_uniformBuffersMemory[VULKAN_SWAPCHAIN_IMAGES_CAP];
-  void* m_uniformBuffersMapped[VULKAN_SWAPCHAIN_IMAGES_CAP];
+  Allocation_t m_indexBufferAllocation;
+  VkBuffer m_atlasBuffer;  // sprite regions, indexed by texId
+  Allocation_t m_atlasBufferAllocation;
+  u64 m_atlasBufferSize;
+  u32 m_uniformBufferLength;
   VkDescriptorPool m_descriptorPool;
-  VkDescriptorSet m_descriptorSets[VULKAN_SWAPCHAIN_IMAGES_CAP];
-  VkCommandBuffer m_commandBuffers[VULKAN_SWAPCHAIN_IMAGES_CAP];
-  VkSemaphore m_imageAvailableSemaphores[VULKAN_SWAPCHAIN_IMAGES_CAP];
-  VkSemaphore m_renderFinishedSemaphores[VULKAN_SWAPCHAIN_IMAGES_CAP];
-  VkFence m_inFlightFences[VULKAN_SWAPCHAIN_IMAGES_CAP];
+
+  // draw commands are cached per frame slot; see Vulkan__FrameContext_t
+  u32 m_drawDirty;
+
+  // the batches are recorded in parallel, as one secondary command buffer per job
+  Jobs_t* m_jobs;
+  VkCommandPool m_recordPools[JOBS_THREADS_CAP];
+  u32 m_drawBatchesCount;  // 0 draws every instance as one batch
+  Vulkan__DrawBatch_t m_drawBatches[VULKAN_DRAW_BATCHES_CAP];
+
+  // deletion queue
+  // every submitted frame gets the next serial. handles which a frame may use are retired with
+  // the serial of the frame being recorded, and destroyed once every frame up to it has completed.
+  // serials only grow, so the queue stays sorted, and is flushed from the front.
+  u64 m_frameSerial;  // of the frame being recorded
+  u64 m_completedSerial;
+  u32 m_retiredHead;
+  u32 m_retiredCount;
+  Vulkan__Retired_t m_retired[VULKAN_RETIRED_CAP];
+
+  // upload ring
+  // persistently mapped host-coherent staging memory, with one slice per frame in flight.
+  // a slice is only rewritten after its frame's fence has signaled.
+  VkBuffer m_uploadRing;
+  Allocation_t m_uploadRingAllocation;
+  u8* m_uploadRingMapped;
+  VkDeviceSize m_uploadRingFrameBytes;
+  VkDeviceSize m_uploadRingHead;
+  // copies out of the ring (or an overflow staging buffer) into a vertex buffer,
+  // recorded at the start of the next frame's command buffer, against that frame's slot
+  u32 m_pendingCopiesCount;
+  VkBuffer m_pendingCopySrcs[VULKAN_PENDING_COPIES_CAP];
+  u8 m_pendingCopyIdxs[VULKAN_PENDING_COPIES_CAP];
+  VkBufferCopy m_pendingCopies[VULKAN_PENDING_COPIES_CAP];
+
+  // uploader
+  // batches staging copies into one submission on the transfer queue, without waiting on it
+  VkCommandPool m_uploadCommandPool;
+  Vulkan__UploadBatch_t m_uploadBatches[VULKAN_UPLOAD_BATCHES_CAP];
+  u8 m_uploadBatch;
+  Vulkan__UploadTicket_t m_uploadTicketNext;
+  Vulkan__UploadTicket_t m_uploadTicketCompleted;
+
+  // gpu culling
+  // a compute pre-pass compacts the on-screen instances of each draw batch within the batch's
+  // span, and writes an indirect draw for each; batches keep their pipeline
+  bool m_gpuCull;
+  VkDescriptorSetLayout m_cullDescriptorSetLayout;
+  VkDescriptorPool m_cullDescriptorPool;
+  VkPipelineLayout m_cullPipelineLayout;
+  VkPipeline m_cullPipeline;
+
+  // gpu profiler
+  // each pass is bracketed by timestamps in the frame slot's query pool. they are read back once
+  // the slot's fence has signaled, so results lag by m_framesInFlight frames, and never stall.
+  bool m_timestamps;  // supported by the graphics queue
+  f32 m_timestampPeriod;  // nanoseconds per tick
+  u64 m_timestampMask;  // valid bits
+  f32 m_passMs[VULKAN_PASSES_COUNT];  // GPU time of each pass last frame, 0 if it didn't run
+
+  // pipeline cache
+  VkPipelineCache m_pipelineCache;
+  const char* m_pipelineCacheFile;
+  u64 m_pipelineCacheShaderHash;
+  bool m_pipelineCacheWarm;
 } Vulkan_t;
 
 void Vulkan__InitDriver1(Vulkan_t* self);
@@ -136,6 +398,9 @@ void Vulkan__CreateDescriptorSetLayout(Vulkan_t* self);
 void Vulkan__CreateShaderModule(
     Vulkan_t* self, const u64 size, const char* code, VkShaderModule* shaderModule);
 void Vulkan__DestroyShaderModule(Vulkan_t* self, const VkShaderModule* shaderModule);
+void Vulkan__LoadPipelineCache(
+    Vulkan_t* self, const char* file, u32 shaderFilesCount, const char* shaderFiles[]);
+void Vulkan__SavePipelineCache(Vulkan_t* self);
 void Vulkan__CreateGraphicsPipeline(
     Vulkan_t* self,
     const char* frag_shader,
@@ -155,46 +420,94 @@ void Vulkan__CreateBuffer(
     VkBufferUsageFlags usage,
     VkMemoryPropertyFlags properties,
     VkBuffer* buffer,
-    VkDeviceMemory* bufferMemory);
-void Vulkan__CreateTextureImage(Vulkan_t* self, const char* file);
+    Allocation_t* allocation);
+void Vulkan__DestroyBuffer(Vulkan_t* self, VkBuffer* buffer, Allocation_t* allocation);
+void Vulkan__CreatePlaceholderTexture(Vulkan_t* self);
+u32 Vulkan__NewTexture(Vulkan_t* self, Vulkan__TextureFilter_t filter);
+void Vulkan__UploadTexture(
+    Vulkan_t* self, u32 texture, u32 width, u32 height, u32 mipsCount, const void* pixels);
+bool Vulkan__IsTextureResident(Vulkan_t* self, u32 texture);
+void Vulkan__CollectTextures(Vulkan_t* self);
+void Vulkan__DestroyTexture(Vulkan_t* self, u32 texture);
 u32 Vulkan__FindMemoryType(Vulkan_t* self, u32 typeFilter, VkMemoryPropertyFlags properties);
-void Vulkan__BeginSingleTimeCommands(Vulkan_t* self, VkCommandBuffer* commandBuffer);
-void Vulkan__EndSingleTimeCommands(Vulkan_t* self, VkCommandBuffer* commandBuffer);
+void Vulkan__CreateUploader(Vulkan_t* self);
+void* Vulkan__UploadStaging(Vulkan_t* self, VkDeviceSize size, VkBuffer* buffer);
+VkCommandBuffer Vulkan__BeginUpload(Vulkan_t* self);
+Vulkan__UploadTicket_t Vulkan__SubmitUploads(Vulkan_t* self);
+bool Vulkan__IsUploadComplete(Vulkan_t* self, Vulkan__UploadTicket_t ticket);
+void Vulkan__AwaitUpload(Vulkan_t* self, Vulkan__UploadTicket_t ticket);
+void Vulkan__CollectUploads(Vulkan_t* self);
+void Vulkan__FlushUploadWaits(Vulkan_t* self);
 void Vulkan__TransitionImageLayout(
     Vulkan_t* self,
     VkImage* image,
     VkFormat format,
+    u32 mipLevels,
     VkImageLayout oldLayout,
     VkImageLayout newLayout);
 void Vulkan__CopyBufferToImage(
-    Vulkan_t* self, VkBuffer* buffer, VkImage* image, u32 width, u32 height);
+    Vulkan_t* self,
+    VkBuffer* buffer,
+    VkDeviceSize offset,
+    VkImage* image,
+    u32 mipLevel,
+    u32 width,
+    u32 height);
 void Vulkan__CreateImage(
     Vulkan_t* self,
     uint32_t width,
     uint32_t height,
+    u32 mipLevels,
     VkFormat format,
     VkImageTiling tiling,
     VkImageUsageFlags usage,
     VkMemoryPropertyFlags properties,
     VkImage* image,
-    VkDeviceMemory* imageMemory);
+    Allocation_t* allocation);
+void Vulkan__DestroyImage(Vulkan_t* self, VkImage* image, Allocation_t* allocation);
 void Vulkan__CreateImageView(
-    Vulkan_t* self, VkImage* image, VkFormat format, VkImageView* imageView);
-void Vulkan__CreateTextureImageView(Vulkan_t* self);
-void Vulkan__CreateTextureSampler(Vulkan_t* self);
+    Vulkan_t* self,
+    VkImage* image,
+    VkFormat format,
+    VkImageAspectFlags aspect,
+    u32 mipLevels,
+    VkImageView* imageView);
+void Vulkan__CreateTextureSamplers(Vulkan_t* self);
 void Vulkan__CreateVertexBuffer(Vulkan_t* self, u8 idx, u64 size, const void* indata);
 void Vulkan__UpdateVertexBuffer(Vulkan_t* self, u8 idx, u64 size, const void* indata);
+void Vulkan__UpdateVertexBufferRegions(
+    Vulkan_t* self, u8 idx, const void* indata, u32 regionsCount, const VkBufferCopy* regions);
+void Vulkan__GrowVertexBuffer(Vulkan_t* self, u8 idx, u64 size);
+void Vulkan__RetireBuffer(Vulkan_t* self, VkBuffer* buffer, Allocation_t* allocation);
+void Vulkan__RetireImage(Vulkan_t* self, VkImage* image, Allocation_t* allocation);
+void Vulkan__RetireImageView(Vulkan_t* self, VkImageView* imageView);
+void Vulkan__RetireFramebuffer(Vulkan_t* self, VkFramebuffer* framebuffer);
+void Vulkan__RetireDescriptorPool(Vulkan_t* self, VkDescriptorPool* descriptorPool);
+void Vulkan__DestroyRetired(Vulkan_t* self, u64 completedSerial);
+void Vulkan__CreateCullPipeline(Vulkan_t* self, const char* comp_shader);
+void Vulkan__RecordCull(Vulkan_t* self, VkCommandBuffer* commandBuffer);
+void Vulkan__CreateUploadRing(Vulkan_t* self, u64 frameBytes);
+void* Vulkan__UploadRingAlloc(Vulkan_t* self, VkDeviceSize size, VkDeviceSize* offset);
+void Vulkan__RecordPendingCopies(Vulkan_t* self, VkCommandBuffer* commandBuffer);
 void Vulkan__CreateIndexBuffer(Vulkan_t* self, u64 size, const void* indata);
+void Vulkan__CreateAtlasBuffer(Vulkan_t* self, u64 size, const void* indata);
 void Vulkan__CreateUniformBuffers(Vulkan_t* self, const unsigned int length);
 void Vulkan__UpdateUniformBuffer(Vulkan_t* self, u8 frame, void* ubo);
 void Vulkan__CreateDescriptorPool(Vulkan_t* self);
 void Vulkan__CreateDescriptorSets(Vulkan_t* self);
 void Vulkan__CreateCommandBuffers(Vulkan_t* self);
 void Vulkan__CreateSyncObjects(Vulkan_t* self);
+const char* Vulkan__PassName(Vulkan__Pass_t pass);
 void Vulkan__DeviceWaitIdle(Vulkan_t* self);
 void Vulkan__CleanupSwapChain(Vulkan_t* self);
 void Vulkan__RecreateSwapChain(Vulkan_t* self);
-void Vulkan__AwaitNextFrame(Vulkan_t* self);
+bool Vulkan__AwaitNextFrame(Vulkan_t* self);
+void Vulkan__InvalidateDrawCommands(Vulkan_t* self, u32 dirty);
+void Vulkan__SetInstanceCount(Vulkan_t* self, u32 count);
+void Vulkan__SetDrawBatches(Vulkan_t* self, u32 count, const Vulkan__DrawBatch_t* batches);
+void Vulkan__CreateRecorders(Vulkan_t* self, Jobs_t* jobs);
+void Vulkan__RecordDrawSecondaries(Vulkan_t* self, u8 frame, u32 jobsCount);
+void Vulkan__RecordFrameCommands(Vulkan_t* self, VkCommandBuffer* commandBuffer);
 void Vulkan__RecordCommandBuffer(Vulkan_t* same, VkCommandBuffer* commandBuffer, u32 imageIndex);
 void Vulkan__DrawFrame(Vulkan_t* self);
 void Vulkan__Cleanup(Vulkan_t* self);
@@ -18,18 +18,27 @@ void Window__New(Window_t* self, char* title, u16 width, u16 height, Vulkan_t* v
   self->height = height;
   self->title = title;
   self->vulkan = vulkan;
+  self->profile = false;
 }
 
 void Window__Begin(Window_t* self) {
+  // headless runs under drivers with no Vulkan surface support (ie. SDL_VIDEODRIVER=dummy),
+  // so the window exists only for its size and event queue
+  const bool headless = self->vulkan->m_headless;
   self->window = SDL_CreateWindow(
       self->title,
       SDL_WINDOWPOS_CENTERED,
       SDL_WINDOWPOS_CENTERED,
       self->width,
       self->height,
-      SDL_WINDOW_VULKAN | SDL_WINDOW_RESIZABLE /* | SDL_WINDOW_SHOWN*/);
+      (headless ? 0 : SDL_WINDOW_VULKAN) | SDL_WINDOW_RESIZABLE /* | SDL_WINDOW_SHOWN*/);
   ASSERT_CONTEXT(NULL != self->window, "SDL_CreateWindow() failed. SDL Error: %s", SDL_GetError())
 
+  if (headless) {
+    self->vulkan->m_requiredDriverExtensionsCount = 0;
+    return;
+  }
+
   // list required extensions, according to SDL window manager
   ASSERT_CONTEXT(
       SDL_TRUE == SDL_Vulkan_GetInstanceExtensions(
@@ -55,6 +64,10 @@ void Window__Shutdown(Window_t* self) {
 }
 
 void Window__Bind(Window_t* self) {
+  if (self->vulkan->m_headless) {
+    return;
+  }
+
   // ask SDL to bind our Vulkan surface to the window surface
   SDL_Vulkan_CreateSurface(self->window, self->vulkan->m_instance, &self->vulkan->m_surface);
   ASSERT_CONTEXT(
@@ -96,10 +109,29 @@ void Window__KeepAspectRatio(Window_t* self, const u32 width, const u32 height)
   self->vulkan->m_viewportY = top;
   self->vulkan->m_viewportWidth = targetWidth;
   self->vulkan->m_viewportHeight = targetHeight;
+  Vulkan__InvalidateDrawCommands(self->vulkan, VULKAN_DIRTY_VIEWPORT);
   self->vulkan->m_bufferWidth = width;
   self->vulkan->m_bufferHeight = height;
 }
 
+/**
+ * One machine-readable line of frame times, averaged over the given frames.
+ */
+static void LogProfile(u32 frames, f64 cpuMs, const f64 gpuMs[VULKAN_PASSES_COUNT]) {
+  char line[256];
+  int length =
+      snprintf(line, sizeof(line), "profile frames=%u cpu_ms=%.3f", frames, cpuMs / frames);
+  for (u8 pass = 0; pass < VULKAN_PASSES_COUNT; pass++) {
+    length += snprintf(
+        line + length,
+        sizeof(line) - length,
+        " gpu_%s_ms=%.3f",
+        Vulkan__PassName(pass),
+        gpuMs[pass] / frames);
+  }
+  LOG_INFOF("%s", line)
+}
+
 void Window__RenderLoop(
     Window_t* self,
     const int physicsFps,
@@ -107,7 +139,9 @@ void Window__RenderLoop(
     void (*physicsCallback)(const f64),
     void (*renderCallback)(const f64)) {
   const u8 physicsInterval = 1000 / physicsFps;
-  const u8 renderInterval = 1000 / renderFps;
+  // a renderFps of 0 renders as fast as frames complete (ie. headless benchmarks)
+  const bool uncapped = 0 == renderFps;
+  const u8 renderInterval = uncapped ? 0 : 1000 / renderFps;
   u64 currentTime = Timer__NowMilliseconds();
   u64 lastPhysics = currentTime - physicsInterval;
   u64 lastRender = currentTime - renderInterval;
@@ -116,7 +150,14 @@ void Window__RenderLoop(
   f64 deltaTime = 0.0f;
   u8 frameCount = 0;
   u8 fpsAvg = 0;
-  char title[100];
+  char title[200];
+  // profiler; sums over the current second, and the averages of the last one
+  u64 lastProfile = currentTime;
+  u32 profileFrames = 0;
+  f64 cpuMsSum = 0.0;
+  f64 gpuMsSum[VULKAN_PASSES_COUNT] = {0};
+  f64 cpuMsAvg = 0.0;
+  f64 gpuMsAvg = 0.0;
   SDL_Event e;
   while (!self->quit) {
     // input handling
@@ -139,6 +180,7 @@ void Window__RenderLoop(
 
             // case SDL_WINDOWEVENT_RESIZED:
             case SDL_WINDOWEVENT_SIZE_CHANGED:
+              // only flags the swapchain; a burst of these recreates it once, on the next frame
               self->vulkan->m_minimized = false;
               Window__KeepAspectRatio(self, e.window.data1, e.window.data2);
               break;
@@ -171,22 +213,52 @@ void Window__RenderLoop(
       // Render update
       currentTime = Timer__NowMilliseconds();
       elapsedRender = currentTime - lastRender;
-      if (elapsedRender > renderInterval) {
-        Vulkan__AwaitNextFrame(self->vulkan);
-
+      // skipped when no swapchain image could be acquired; the next pass retries
+      if ((uncapped || elapsedRender > renderInterval) && Vulkan__AwaitNextFrame(self->vulkan)) {
         currentTime = Timer__NowMilliseconds();
         deltaTime = 1.0f / MATH_MAX(1, (currentTime - lastRender));
         lastRender = currentTime;
 
+        const u64 cpuStart = Now();
         renderCallback(deltaTime);
         Vulkan__DrawFrame(self->vulkan);
+        cpuMsSum += (f64)(Now() - cpuStart) / CYCLES_PER_MILLISECOND;
+        // GPU times trail by the frames in flight; see Vulkan_t.m_passMs
+        for (u8 pass = 0; pass < VULKAN_PASSES_COUNT; pass++) {
+          gpuMsSum[pass] += self->vulkan->m_passMs[pass];
+        }
+        profileFrames++;
+
+        if (currentTime - lastProfile >= 1000) {
+          cpuMsAvg = cpuMsSum / profileFrames;
+          gpuMsAvg = 0.0;
+          for (u8 pass = 0; pass < VULKAN_PASSES_COUNT; pass++) {
+            gpuMsAvg += gpuMsSum[pass] / profileFrames;
+          }
+          if (self->profile) {
+            LogProfile(profileFrames, cpuMsSum, gpuMsSum);
+          }
+          lastProfile = currentTime;
+          profileFrames = 0;
+          cpuMsSum = 0.0;
+          for (u8 pass = 0; pass < VULKAN_PASSES_COUNT; pass++) {
+            gpuMsSum[pass] = 0.0;
+          }
+        }
 
         frameCount++;
-        if (frameCount >= renderFps) {
+        if (!uncapped && frameCount >= renderFps) {
           fpsAvg = 1 / (deltaTime / frameCount);
           // if titlebar updates are tracking with the wall clock seconds hand, then loop is on-time
           // the value shown is potential frames (ie. accounts for spare cycles)
-          sprintf(title, "%s | pFPS: %u", self->title, fpsAvg);
+          snprintf(
+              title,
+              sizeof(title),
+              "%s | pFPS: %u | CPU %.2f ms | GPU %.2f ms",
+              self->title,
+              fpsAvg,
+              cpuMsAvg,
+              gpuMsAvg);
           SDL_SetWindowTitle(self->window, title);
           frameCount = 0;
         }
@@ -194,6 +266,8 @@ void Window__RenderLoop(
     }
 
     // sleep to control the frame rate
-    SLEEP(1);
+    if (!uncapped) {
+      SLEEP(1);
+    }
   }
 }
\ No newline at end of file
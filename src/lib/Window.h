@@ -17,6 +17,8 @@ typedef struct {
   u16 width;
   u16 height;
   Vulkan_t* vulkan;
+  // log CPU and per-pass GPU frame times each second, as key=value lines
+  bool profile;
 } Window_t;
 
 void Window__New(Window_t* self, char* title, u16 width, u16 height, Vulkan_t* vulkan);
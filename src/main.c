@@ -1,12 +1,21 @@
 #define CGLM_FORCE_DEPTH_ZERO_TO_ONE
 #include <cglm/cglm.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
+#include "lib/Atlas.h"
 #include "lib/Audio.h"
+#include "lib/File.h"
 #include "lib/Finger.h"
 #include "lib/Gamepad.h"
+#include "lib/Grid.h"
+#include "lib/Instances.h"
+#include "lib/Jobs.h"
 #include "lib/Keyboard.h"
+#include "lib/Loader.h"
 #include "lib/Math.h"
+#include "lib/RenderQueue.h"
 #include "lib/SDL.h"
 #include "lib/Timer.h"
 #include "lib/Vulkan.h"
@@ -23,8 +32,18 @@ static const u8 RENDER_FPS = 60;
 static const f32 PLAYER_WALK_SPEED = 1.0f / 3;  // per-second
 static const f32 PLAYER_ZOOM_SPEED = 1.0f / 8;  // per-second
 
-static bool isVBODirty = true;
-static bool isUBODirty[] = {true, true};
+// one per frame in flight, since each has its own uniform buffer
+static bool isUBODirty[VULKAN_FRAMES_IN_FLIGHT_CAP];
+static u32 s_FramesInFlight = VULKAN_FRAMES_IN_FLIGHT_DEFAULT;
+// offscreen rendering, uncapped; for benchmarks (ie. SDL_VIDEODRIVER=dummy with lavapipe)
+static bool s_Headless = false;
+static bool s_Profile = false;
+
+static void MarkUBODirty() {
+  for (u8 i = 0; i < VULKAN_FRAMES_IN_FLIGHT_CAP; i++) {
+    isUBODirty[i] = true;
+  }
+}
 
 static Vulkan_t s_Vulkan;
 static Window_t s_Window;
@@ -33,22 +52,59 @@ typedef struct {
   vec2 vertex;
 } Mesh_t;
 
-typedef struct {
-  vec3 pos;
-  vec3 rot;
-  vec3 scale;
-  u32 texId;
-} Instance_t;
-
-#define MAX_INSTANCES 255  // TODO: find out how to exceed this limit
-static u16 instanceCount = 1;
-static Instance_t instances[MAX_INSTANCES];
+static Instances_t s_Instances;
+
+// the instances drawn are sorted by render key, packed in that order, uploaded, and drawn as
+// the fewest draws the key allows
+// - upright sprites are y-sorted by their feet; the queue keeps last frame's order, so only
+//   what moved, or came into view, is sorted again
+// - while no instance is added, only the changed ones are re-keyed, each moved to its new slot;
+//   the slots between shift by one, and only those spans are repacked and uploaded
+static InstanceGpu_t* s_Visible;
+static u32 s_VisibleCap;
+static u32 s_VisibleCount;
+static RenderQueue_t s_Queue;
+static u64* s_QueueKeys;  // by instance; RENDER_QUEUE_NONE between frames
+static u32* s_QueueSlots;  // by instance; where it is packed
+static u32 s_QueueKeysCap;
+static void QueuePack(const u32* ids, u32 count);
+static u64 QueueUpload();
+
+// cpu culling: --cpu-cull
+// instances are indexed by a uniform grid; only those in view are queued
+#define GRID_CELL_SIZE 0.5f  // units
+static bool s_CpuCull = false;
+static Grid_t s_Grid;
+static vec4 s_VisibleRect;
+static void CullTrack(u32 idx);
+static u64 CullUpload();
 
 enum INSTANCES {
   INSTANCE_FLOOR_0 = 0,
   INSTANCE_PLAYER_1 = 1,
+  INSTANCE_WALLS_2 = 2,  // and every instance after
+};
+
+// sprite layers, from back to front; each is raised LAYER_DEPTH above the one before,
+// so the depth test keeps them stacked in this order whatever order they are drawn in
+// - characters and walls share the upright layer; they overlap by where their feet are instead
+enum LAYERS {
+  LAYER_FLOOR = 0,
+  LAYER_UPRIGHT = 1,
+  LAYERS_COUNT,
+};
+#define LAYER_DEPTH 0.001f  // units
+
+// render passes; the most significant part of a render key
+// opaque sprites are drawn first, front-to-back, then translucent ones blend over them
+enum PASSES {
+  PASS_OPAQUE = 0,
+  PASS_BLENDED = 1,
 };
 
+// draw recording is spread over a job pool
+static Jobs_t s_Jobs;
+
 typedef struct {
   vec3 cam;
   vec3 look;
@@ -68,23 +124,43 @@ typedef struct {
   vec2 user2;
 } ubo_ProjView_t;
 
-static Mesh_t vertices[] = {
+// every sprite is drawn as a fan over ATLAS_MESH_CAP slots; the shader takes each slot from the
+// region's mesh, if it has one, or else from here: the whole quad, its later slots degenerate
+static Mesh_t vertices[ATLAS_MESH_CAP] = {
     {{-0.5f, -0.5f}},
     {{0.5f, -0.5f}},
     {{0.5f, 0.5f}},
     {{-0.5f, 0.5f}},
+    {{-0.5f, 0.5f}},
+    {{-0.5f, 0.5f}},
+    {{-0.5f, 0.5f}},
+    {{-0.5f, 0.5f}},
 };
 
-static u16 indices[] = {0, 1, 2, 2, 3, 0};
+static u16 indices[(ATLAS_MESH_CAP - 2) * 3] = {
+    0, 1, 2, 0, 2, 3, 0, 3, 4, 0, 4, 5, 0, 5, 6, 0, 6, 7,
+};
 
 static const char* shaderFiles[] = {
     "../assets/shaders/simple_shader.frag.spv",
     "../assets/shaders/simple_shader.vert.spv",
+    "../assets/shaders/cull.comp.spv",
 };
 
 static const char* textureFiles[] = {
     "../assets/textures/atlas.png",
 };
+// decoded in the background; each is uploaded once decoded, and drawn once resident
+static Loader_t s_Loader;
+static Loader__Image_t s_TextureImages[ARRAY_COUNT(textureFiles)];
+static u32 s_Textures[ARRAY_COUNT(textureFiles)];
+static bool s_TexturesUploaded[ARRAY_COUNT(textureFiles)];
+
+static const char* atlasFiles[] = {
+    "../assets/textures/atlas.txt",
+};
+static Atlas_t s_Atlas;
+static void CheckTexIds();
 
 static const char* audioFiles[] = {
     "../assets/audio/music/grassland.wav",
@@ -100,6 +176,54 @@ enum AUDIO_FILES {
 
 static ubo_ProjView_t ubo1;  // projection x view matrices
 
+// stress benchmark: --bench-instances N
+// places N walls, then reports frame time and instance upload cost
+#define BENCH_FRAMES 600
+#define BENCH_CHURN 64  // instances rewritten per frame
+typedef struct {
+  u32 instances;
+  u32 frame;
+  u64 frameStart;  // Now() when the last frame's callback began
+  f64 frameMs;     // each from one frame's callback to the next's
+  f64 frameMsMax;
+  u64 windowStart;  // Now() at the first frame, for wall clock throughput
+  u64 windowEnd;
+  u64 transformCycles;
+  u64 uploadCycles;
+  u64 uploadBytes;
+  u64 firstUploadCycles;
+  u64 firstUploadBytes;
+} Bench_t;
+static Bench_t s_Bench;
+static void BenchPlaceInstances(u32 count);
+static void BenchReport();
+
+// recording benchmark: --bench-record N
+// records N draw batches on 1, 2, 4... job threads, reports the time for each, then quits
+#define BENCH_RECORD_REPEATS 100
+static u32 s_BenchRecordBatches = 0;
+static void BenchRecord(u32 batchesCount);
+
+// texture loading benchmark: --bench-textures
+// loads each texture from PNG and from its cache, with cold and warm page cache, then quits
+#define BENCH_TEXTURE_REPEATS 5
+static bool s_BenchTextures = false;
+static void BenchTextures();
+
+// render queue benchmark: --bench-queue
+// sorts and merges the render keys of 100k and 1M random sprites, then re-sorts them frame after
+// frame as a few move and the view pans, then quits
+#define BENCH_QUEUE_REPEATS 10
+static bool s_BenchQueue = false;
+static void BenchQueue();
+
+// offline mesh baking: --bake-meshes
+// fits a mesh around the opaque pixels of every atlas region, writes them into the atlas file,
+// then quits
+static bool s_BakeMeshes = false;
+static void BakeMeshes();
+
+static bool UploadDecodedTextures();
 static void physicsCallback(const f64 deltaTime);
 static void renderCallback(const f64 deltaTime);
 static void keyboardCallback();
@@ -187,19 +311,67 @@ u8 Animate(AnimationState_t* state, f64 deltaTime) {
   return texId;
 }
 
-int main() {
+int main(int argc, char* argv[]) {
   printf("begin main.\n");
 
+  for (int i = 1; i < argc; i++) {
+    if (0 == strcmp(argv[i], "--bench-instances") && i + 1 < argc) {
+      s_Bench.instances = strtoul(argv[++i], NULL, 10);
+    } else if (0 == strcmp(argv[i], "--gpu-cull")) {
+      s_Vulkan.m_gpuCull = true;
+    } else if (0 == strcmp(argv[i], "--cpu-cull")) {
+      s_CpuCull = true;
+    } else if (0 == strcmp(argv[i], "--bench-record") && i + 1 < argc) {
+      s_BenchRecordBatches = strtoul(argv[++i], NULL, 10);
+    } else if (0 == strcmp(argv[i], "--bench-textures")) {
+      s_BenchTextures = true;
+    } else if (0 == strcmp(argv[i], "--bench-queue")) {
+      s_BenchQueue = true;
+    } else if (0 == strcmp(argv[i], "--bake-meshes")) {
+      s_BakeMeshes = true;
+    } else if (0 == strcmp(argv[i], "--frames-in-flight") && i + 1 < argc) {
+      s_FramesInFlight = strtoul(argv[++i], NULL, 10);
+    } else if (0 == strcmp(argv[i], "--headless")) {
+      s_Headless = true;
+    } else if (0 == strcmp(argv[i], "--profile")) {
+      s_Profile = true;
+    }
+  }
+
   Timer__MeasureCycles();
 
   // initialize random seed using current time
   srand(Timer__NowMilliseconds());
 
   Vulkan__InitDriver1(&s_Vulkan);
+  s_Vulkan.m_framesInFlight = MATH_MIN(MATH_MAX(s_FramesInFlight, 1), VULKAN_FRAMES_IN_FLIGHT_CAP);
+  s_Vulkan.m_headless = s_Headless;
+  MarkUBODirty();
 
   Window__New(&s_Window, WINDOW_TITLE, WINDOW_WIDTH, WINDOW_HEIGHT, &s_Vulkan);
+  s_Window.profile = s_Profile;
   SDL__Init();
   Audio__Init();
+  Jobs__New(&s_Jobs, SDL_GetCPUCount());
+  if (s_BenchTextures) {
+    // before the loader starts, which would race it for the cache files
+    BenchTextures();
+    s_Window.quit = true;
+  }
+  if (s_BenchQueue) {
+    BenchQueue();
+    s_Window.quit = true;
+  }
+  if (s_BakeMeshes) {
+    BakeMeshes();
+    s_Window.quit = true;
+  }
+  // start decoding first; it overlaps the rest of startup
+  Loader__New(&s_Loader, SDL_GetCPUCount());
+  for (u32 i = 0; i < ARRAY_COUNT(textureFiles); i++) {
+    s_TextureImages[i].file = textureFiles[i];
+  }
+  Loader__Decode(&s_Loader, ARRAY_COUNT(textureFiles), s_TextureImages);
 
   Audio__LoadAudioFile(audioFiles[AUDIO_AMBIENCE]);
   Audio__PlayAudio(AUDIO_AMBIENCE, true, 6.0f);
@@ -241,6 +413,7 @@ int main() {
   // establish vulkan scene
   Vulkan__AssertSwapChainSupported(&s_Vulkan);
   Vulkan__CreateLogicalDeviceAndQueues(&s_Vulkan);
+  Vulkan__LoadPipelineCache(&s_Vulkan, "pipeline.cache", ARRAY_COUNT(shaderFiles), shaderFiles);
   Vulkan__CreateSwapChain(&s_Vulkan, false);
   Vulkan__CreateImageViews(&s_Vulkan);
   Vulkan__CreateRenderPass(&s_Vulkan);
@@ -250,34 +423,59 @@ int main() {
       shaderFiles[0],
       shaderFiles[1],
       sizeof(Mesh_t),
-      sizeof(Instance_t),
-      5,
-      (u32[5]){0, 1, 1, 1, 1},
-      (u32[5]){0, 1, 2, 3, 4},
-      (u32[5]){
+      sizeof(InstanceGpu_t),
+      6,
+      (u32[6]){0, 1, 1, 1, 1, 1},
+      (u32[6]){0, 1, 2, 3, 4, 5},
+      (u32[6]){
           VK_FORMAT_R32G32_SFLOAT,
-          VK_FORMAT_R32G32B32_SFLOAT,
-          VK_FORMAT_R32G32B32_SFLOAT,
-          VK_FORMAT_R32G32B32_SFLOAT,
+          VK_FORMAT_R32G32B32A32_SFLOAT,
+          VK_FORMAT_R32G32B32A32_SFLOAT,
+          VK_FORMAT_R32G32B32A32_SFLOAT,
+          VK_FORMAT_R32_UINT,
           VK_FORMAT_R32_UINT},
-      (u32[5]){
+      (u32[6]){
           offsetof(Mesh_t, vertex),
-          offsetof(Instance_t, pos),
-          offsetof(Instance_t, rot),
-          offsetof(Instance_t, scale),
-          offsetof(Instance_t, texId)});
+          offsetof(InstanceGpu_t, model) + sizeof(f32) * 0,
+          offsetof(InstanceGpu_t, model) + sizeof(f32) * 4,
+          offsetof(InstanceGpu_t, model) + sizeof(f32) * 8,
+          offsetof(InstanceGpu_t, texId),
+          offsetof(InstanceGpu_t, texture)});
   Vulkan__CreateFrameBuffers(&s_Vulkan);
   Vulkan__CreateCommandPool(&s_Vulkan);
-  Vulkan__CreateTextureImage(&s_Vulkan, textureFiles[0]);
-  Vulkan__CreateTextureImageView(&s_Vulkan);
-  Vulkan__CreateTextureSampler(&s_Vulkan);
+  Vulkan__CreateUploader(&s_Vulkan);
+  Vulkan__CreatePlaceholderTexture(&s_Vulkan);
+  for (u32 i = 0; i < ARRAY_COUNT(textureFiles); i++) {
+    s_Textures[i] = Vulkan__NewTexture(&s_Vulkan, VULKAN_TEXTURE_FILTER_PIXEL_ART);
+  }
+  UploadDecodedTextures();
+  Vulkan__CreateTextureSamplers(&s_Vulkan);
   Vulkan__CreateVertexBuffer(&s_Vulkan, 0, sizeof(vertices), vertices);
-  Vulkan__CreateVertexBuffer(&s_Vulkan, 1, sizeof(instances), instances);
+  Instances__New(&s_Instances, INSTANCES_MIN_CAP);
+  Grid__New(&s_Grid, GRID_CELL_SIZE);
+  RenderQueue__New(&s_Queue);
+  Vulkan__CreateVertexBuffer(
+      &s_Vulkan,
+      1,
+      sizeof(InstanceGpu_t) * s_Instances.m_cap,
+      s_Instances.m_gpu);
   Vulkan__CreateIndexBuffer(&s_Vulkan, sizeof(indices), indices);
+  Atlas__Load(&s_Atlas, atlasFiles[0]);
+  Vulkan__CreateAtlasBuffer(
+      &s_Vulkan,
+      sizeof(AtlasRegion_t) * s_Atlas.m_count,
+      s_Atlas.m_regions);
+  Vulkan__CreateUploadRing(&s_Vulkan, VULKAN_UPLOAD_RING_FRAME_BYTES);
+  // one submission for all initial uploads; the first frame waits on it
+  Vulkan__SubmitUploads(&s_Vulkan);
   Vulkan__CreateUniformBuffers(&s_Vulkan, sizeof(ubo1));
   Vulkan__CreateDescriptorPool(&s_Vulkan);
   Vulkan__CreateDescriptorSets(&s_Vulkan);
+  if (s_Vulkan.m_gpuCull) {
+    Vulkan__CreateCullPipeline(&s_Vulkan, shaderFiles[2]);
+  }
   Vulkan__CreateCommandBuffers(&s_Vulkan);
+  Vulkan__CreateRecorders(&s_Vulkan, &s_Jobs);
   Vulkan__CreateSyncObjects(&s_Vulkan);
   s_Vulkan.m_drawIndexCount = ARRAY_COUNT(indices);
 
@@ -285,30 +483,65 @@ int main() {
   glm_vec3_copy((vec3){0, 0, 1}, world.cam);
   glm_vec3_copy((vec3){0, 0, 0}, world.look);
 
+  ASSERT(INSTANCE_FLOOR_0 == Instances__Add(&s_Instances))
+  ASSERT(INSTANCE_PLAYER_1 == Instances__Add(&s_Instances))
+  Instance_t* instances = s_Instances.m_data;
   glm_vec3_copy((vec3){0, 0, 0}, instances[INSTANCE_FLOOR_0].pos);
   glm_vec3_copy((vec3){0, 0, 0}, instances[INSTANCE_FLOOR_0].rot);
   glm_vec3_copy(
       (vec3){PixelsToUnits(2632), PixelsToUnits(1721), 1},
       instances[INSTANCE_FLOOR_0].scale);
   instances[INSTANCE_FLOOR_0].texId = 0;
-  instanceCount = 1;
+  instances[INSTANCE_FLOOR_0].texture = s_Textures[0];
+  instances[INSTANCE_FLOOR_0].layer = LAYER_FLOOR;
+  // blended over the clear color, after the upright sprites; they sit LAYER_DEPTH above it,
+  // so the floor they cover still fails the depth test
+  instances[INSTANCE_FLOOR_0].translucent = true;
 
-  glm_vec3_copy((vec3){0, 0, 0}, instances[INSTANCE_PLAYER_1].pos);
+  glm_vec3_copy((vec3){0, 0, LAYER_UPRIGHT * LAYER_DEPTH}, instances[INSTANCE_PLAYER_1].pos);
   glm_vec3_copy((vec3){0, 0, 0}, instances[INSTANCE_PLAYER_1].rot);
   glm_vec3_copy(
       (vec3){PixelsToUnits(300), PixelsToUnits(450), 1},
       instances[INSTANCE_PLAYER_1].scale);
   instances[INSTANCE_PLAYER_1].texId = 4;
-  instanceCount++;
+  instances[INSTANCE_PLAYER_1].texture = s_Textures[0];
+  instances[INSTANCE_PLAYER_1].layer = LAYER_UPRIGHT;
+  CullTrack(INSTANCE_FLOOR_0);
+  CullTrack(INSTANCE_PLAYER_1);
+
+  if (s_Bench.instances > 0) {
+    BenchPlaceInstances(s_Bench.instances);
+  }
+  if (s_BenchRecordBatches > 0) {
+    BenchRecord(s_BenchRecordBatches);
+    s_Window.quit = true;
+  }
 
   // main loop
-  Window__RenderLoop(&s_Window, PHYSICS_FPS, RENDER_FPS, &physicsCallback, &renderCallback);
+  Window__RenderLoop(
+      &s_Window,
+      PHYSICS_FPS,
+      s_Headless ? 0 : RENDER_FPS,
+      &physicsCallback,
+      &renderCallback);
 
   // cleanup
   printf("shutdown main.\n");
   Vulkan__DeviceWaitIdle(&s_Vulkan);
   Gamepad__Shutdown(&gamePad1);
+  Loader__Shutdown(&s_Loader);
+  for (u32 i = 0; i < ARRAY_COUNT(textureFiles); i++) {
+    Loader__Free(&s_TextureImages[i]);
+  }
   Vulkan__Cleanup(&s_Vulkan);
+  Jobs__Shutdown(&s_Jobs);
+  Instances__Shutdown(&s_Instances);
+  Atlas__Shutdown(&s_Atlas);
+  Grid__Shutdown(&s_Grid);
+  RenderQueue__Shutdown(&s_Queue);
+  free(s_Visible);
+  free(s_QueueKeys);
+  free(s_QueueSlots);
   Audio__Shutdown();
   Window__Shutdown(&s_Window);
   printf("end main.\n");
@@ -403,8 +636,7 @@ static void fingerCallback() {
     // TODO: how to animate camera zoom with spring damping/smoothing?
     // TODO: how to move this into physics callback? or is it better not to?
     world.cam[2] += -g_Finger__state.wheel_y * PLAYER_ZOOM_SPEED /* deltaTime*/;
-    isUBODirty[0] = true;
-    isUBODirty[1] = true;
+    MarkUBODirty();
   }
 
   else if (FINGER_DOWN == g_Finger__state.event) {
@@ -419,16 +651,19 @@ static void fingerCallback() {
     vec3 dest;
     glm_unproject(pos, pvMatrix, viewport, dest);
 
-    instances[instanceCount].pos[0] = dest[0];
-    instances[instanceCount].pos[1] = dest[1];
-    instances[instanceCount].pos[2] = 0.0f;  // dest[2];
+    const u32 idx = Instances__Add(&s_Instances);
+    Instance_t* wall = &s_Instances.m_data[idx];
+    wall->pos[0] = dest[0];
+    wall->pos[1] = dest[1];
+    wall->pos[2] = LAYER_UPRIGHT * LAYER_DEPTH;
 
-    instances[instanceCount].scale[0] = PixelsToUnits(350 / 2);
-    instances[instanceCount].scale[1] = PixelsToUnits(420 / 2);
-    instances[instanceCount].scale[2] = 1.0f;
-    instances[instanceCount].texId = 2;  // wood-wall 1
-    instanceCount++;
-    isVBODirty = true;
+    wall->scale[0] = PixelsToUnits(350 / 2);
+    wall->scale[1] = PixelsToUnits(420 / 2);
+    wall->scale[2] = 1.0f;
+    wall->texId = 2;  // wood-wall 1
+    wall->texture = s_Textures[0];
+    wall->layer = LAYER_UPRIGHT;
+    CullTrack(idx);
 
     Audio__PlayAudio(AUDIO_SET_WOOD_WALL, false, 1.0f);
   }
@@ -436,6 +671,7 @@ static void fingerCallback() {
 
 void physicsCallback(const f64 deltaTime) {
   // OnFixedUpdate(deltaTime);
+  Instance_t* instances = s_Instances.m_data;
   if (WALK == playerAnimationState.state) {
     if (LEFT == playerAnimationState.facing) {
       instances[INSTANCE_PLAYER_1].pos[0] -= PLAYER_WALK_SPEED * deltaTime;
@@ -446,33 +682,115 @@ void physicsCallback(const f64 deltaTime) {
     } else if (FRONT == playerAnimationState.facing) {
       instances[INSTANCE_PLAYER_1].pos[1] += PLAYER_WALK_SPEED * deltaTime;
     }
-    isVBODirty = true;
+    Instances__MarkDirty(&s_Instances, INSTANCE_PLAYER_1, 1);
+    if (s_CpuCull) {
+      Grid__Move(
+          &s_Grid,
+          INSTANCE_PLAYER_1,
+          instances[INSTANCE_PLAYER_1].pos[0],
+          instances[INSTANCE_PLAYER_1].pos[1]);
+    }
 
     world.cam[0] = instances[INSTANCE_PLAYER_1].pos[0];
     world.cam[1] = instances[INSTANCE_PLAYER_1].pos[1];
     world.look[0] = instances[INSTANCE_PLAYER_1].pos[0];
     world.look[1] = instances[INSTANCE_PLAYER_1].pos[1];
-    isUBODirty[0] = true;
-    isUBODirty[1] = true;
+    MarkUBODirty();
   }
 }
 
 static u8 newTexId;
+/**
+ * Queue any textures decoded since the last call. Their uploads don't block either;
+ * the placeholder is drawn until they are resident. Returns whether any were queued.
+ */
+static bool UploadDecodedTextures() {
+  bool uploaded = false;
+  for (u32 i = 0; i < ARRAY_COUNT(textureFiles); i++) {
+    Loader__Image_t* image = &s_TextureImages[i];
+    if (s_TexturesUploaded[i] || !Loader__IsDecoded(image)) {
+      continue;
+    }
+    s_TexturesUploaded[i] = true;
+    if (NULL == image->pixels) {
+      continue;  // already logged; stays the placeholder
+    }
+    Vulkan__UploadTexture(
+        &s_Vulkan,
+        s_Textures[i],
+        image->width,
+        image->height,
+        image->mipsCount,
+        image->pixels);
+    Loader__Free(image);
+    uploaded = true;
+  }
+  return uploaded;
+}
+
 static void renderCallback(const f64 deltaTime) {
+  // deltaTime is 1 / elapsed ms, clamped; not precise enough to benchmark with
+  const u64 frameStart = Now();
   // OnUpdate(deltaTime);
+  if (UploadDecodedTextures()) {
+    Vulkan__SubmitUploads(&s_Vulkan);
+  }
 
   // character frame animation
   newTexId = Animate(&playerAnimationState, deltaTime);
-  if (instances[1].texId != newTexId) {
-    instances[1].texId = newTexId;
-    isVBODirty = true;
+  if (s_Instances.m_data[INSTANCE_PLAYER_1].texId != newTexId) {
+    s_Instances.m_data[INSTANCE_PLAYER_1].texId = newTexId;
+    Instances__MarkDirty(&s_Instances, INSTANCE_PLAYER_1, 1);
   }
 
-  if (isVBODirty) {
-    isVBODirty = false;
+  if (s_Bench.instances > 0 && s_Bench.frame > 0) {
+    // rewrite a contiguous run, as if a chunk of the base was edited
+    const u32 span = s_Bench.instances - MATH_MIN(s_Bench.instances, BENCH_CHURN) + 1;
+    // NOTICE: RAND_MAX may be as small as 32767
+    const u32 first = 2 + (((u32)rand() * (RAND_MAX + 1u) + rand()) % span);
+    const u32 count = MATH_MIN(BENCH_CHURN, s_Instances.m_count - first);
+    for (u32 i = first; i < first + count; i++) {
+      s_Instances.m_data[i].texId = 2;
+    }
+    Instances__MarkDirty(&s_Instances, first, count);
+  }
+
+  CheckTexIds();
+
+  // rebuild model matrices for the instances which changed
+  const u64 transformStart = Now();
+  Instances__UpdateTransforms(&s_Instances);
+  const u64 transformCycles = Now() - transformStart;
+
+  // upload only the instances which changed
+  const u64 uploadStart = Now();
+  u64 uploadBytes = 0;
+  if (s_CpuCull) {
+    uploadBytes = CullUpload();
+  } else {
+    uploadBytes = QueueUpload();
+  }
 
-    s_Vulkan.m_instanceCount = instanceCount;
-    Vulkan__UpdateVertexBuffer(&s_Vulkan, 1, sizeof(instances), instances);
+  if (s_Bench.instances > 0) {
+    const u64 uploadCycles = Now() - uploadStart;
+    if (0 == s_Bench.frame) {
+      s_Bench.firstUploadCycles = uploadCycles;
+      s_Bench.firstUploadBytes = uploadBytes;
+      s_Bench.windowStart = frameStart;
+    } else {
+      const f64 frameMs = (f64)(frameStart - s_Bench.frameStart) / CYCLES_PER_MILLISECOND;
+      s_Bench.frameMs += frameMs;
+      s_Bench.frameMsMax = MATH_MAX(s_Bench.frameMsMax, frameMs);
+      s_Bench.transformCycles += transformCycles;
+      s_Bench.uploadCycles += uploadCycles;
+      s_Bench.uploadBytes += uploadBytes;
+    }
+    s_Bench.frameStart = frameStart;
+    if (++s_Bench.frame > BENCH_FRAMES) {
+      s_Bench.windowEnd = frameStart;
+      BenchReport();
+      s_Window.quit = true;
+    }
   }
 
   if (isUBODirty[s_Vulkan.m_currentFrame]) {
@@ -501,3 +819,506 @@ static void renderCallback(const f64 deltaTime) {
     Vulkan__UpdateUniformBuffer(&s_Vulkan, s_Vulkan.m_currentFrame, &ubo1);
   }
 }
+
+static void BenchPlaceInstances(u32 count) {
+  // a square grid of walls centered on the player
+  const u32 side = (u32)ceil(sqrt((f64)count));
+  const f32 spacing = PixelsToUnits(350 / 2);
+  for (u32 i = 0; i < count; i++) {
+    const u32 idx = Instances__Add(&s_Instances);
+    Instance_t* wall = &s_Instances.m_data[idx];
+    wall->pos[0] = ((f32)(i % side) - side / 2.0f) * spacing;
+    wall->pos[1] = ((f32)(i / side) - side / 2.0f) * spacing;
+    wall->pos[2] = LAYER_UPRIGHT * LAYER_DEPTH;
+    wall->scale[0] = PixelsToUnits(350 / 2);
+    wall->scale[1] = PixelsToUnits(420 / 2);
+    wall->scale[2] = 1.0f;
+    wall->texId = 2;  // wood-wall 1
+    wall->texture = s_Textures[0];
+    wall->layer = LAYER_UPRIGHT;
+    CullTrack(idx);
+  }
+  LOG_INFOF("bench: placed %u instances, capacity %u", count, s_Instances.m_cap)
+}
+
+static void BenchReport() {
+  const u32 frames = s_Bench.frame - 1;
+  LOG_INFOF(
+      "bench: %u instances, first upload %llu KB in %.3f ms",
+      s_Bench.instances,
+      (unsigned long long)(s_Bench.firstUploadBytes / 1024),
+      (f64)s_Bench.firstUploadCycles / CYCLES_PER_MILLISECOND)
+  LOG_INFOF(
+      "bench: %u frames%s, frame time avg %.3f ms max %.3f ms (%.1f fps), "
+      "transform avg %.4f ms, upload avg %.3f KB in %.4f ms per frame",
+      frames,
+      s_Headless ? " headless" : "",
+      s_Bench.frameMs / frames,
+      s_Bench.frameMsMax,
+      1000 * frames / s_Bench.frameMs,
+      (f64)s_Bench.transformCycles / CYCLES_PER_MILLISECOND / frames,
+      (f64)s_Bench.uploadBytes / 1024 / frames,
+      (f64)s_Bench.uploadCycles / CYCLES_PER_MILLISECOND / frames)
+  const f64 wallMs = (f64)(s_Bench.windowEnd - s_Bench.windowStart) / CYCLES_PER_MILLISECOND;
+  LOG_INFOF(
+      "bench: %u frames%s in %.1f ms wall clock, %.3f ms per frame, %.1f fps",
+      frames,
+      s_Headless ? " headless" : "",
+      wallMs,
+      wallMs / frames,
+      1000 * frames / wallMs)
+}
+
+/**
+ * Catch an instance set to an atlas region which doesn't exist, before the vertex shader reads
+ * it from past the end of the atlas buffer. Only the instances which changed are checked.
+ */
+static void CheckTexIds() {
+  for (u32 r = 0; r < s_Instances.m_dirtyCount; r++) {
+    const Instances__Range_t range = s_Instances.m_dirty[r];
+    for (u32 i = range.first; i < range.first + range.count; i++) {
+      ASSERT_CONTEXT(
+          s_Instances.m_data[i].texId < s_Atlas.m_count,
+          "Instance has no such atlas region. instance: %u, texId: %u, regions: %u",
+          i,
+          s_Instances.m_data[i].texId,
+          s_Atlas.m_count)
+    }
+  }
+}
+
+static void CullTrack(u32 idx) {
+  if (!s_CpuCull) {
+    return;
+  }
+  const Instance_t* instance = &s_Instances.m_data[idx];
+  Grid__Insert(
+      &s_Grid,
+      idx,
+      instance->pos[0],
+      instance->pos[1],
+      instance->scale[0] / 2,
+      instance->scale[1] / 2);
+}
+
+/**
+ * The render key of an instance.
+ * Upright sprites share a plane, so between them only draw order decides which is in front:
+ * the one whose feet are lower on screen, ie. nearer. Vulkan's y points down, so world +y is
+ * down the screen, and an image's bottom row is at +y. Sprites go farthest feet first, ie. by
+ * ascending feet y, in either pass, and equal depths pass the depth test. Whole layers still go
+ * front to back in the opaque pass, so covered floor is rejected before it is shaded;
+ * translucent layers blend back to front.
+ */
+static u64 InstanceKey(const Instance_t* instance) {
+  const f32 feetY = instance->pos[1] + fabsf(instance->scale[1]) / 2;
+  if (instance->translucent) {
+    return RenderQueue__Key(
+        PASS_BLENDED * LAYERS_COUNT + instance->layer,
+        VULKAN_PIPELINE_BLENDED,
+        feetY,
+        instance->texture);
+  }
+  return RenderQueue__Key(
+      PASS_OPAQUE * LAYERS_COUNT + (LAYERS_COUNT - 1 - instance->layer),
+      VULKAN_PIPELINE_OPAQUE,
+      feetY,
+      instance->texture);
+}
+
+/**
+ * Queue the given instances by render key, or the first count when ids is NULL, and pack them
+ * in that order into s_Visible. What stayed queued keeps last frame's order, re-keyed; what
+ * came in is pushed after.
+ */
+static void QueuePack(const u32* ids, u32 count) {
+  if (count > s_VisibleCap) {
+    s_VisibleCap = MATH_MAX(count, s_VisibleCap * 2);
+    s_Visible = realloc(s_Visible, s_VisibleCap * sizeof(InstanceGpu_t));
+    ASSERT(s_Visible)
+  }
+  if (s_Instances.m_count > s_QueueKeysCap) {
+    const u32 cap = s_Instances.m_cap;
+    s_QueueKeys = realloc(s_QueueKeys, cap * sizeof(u64));
+    s_QueueSlots = realloc(s_QueueSlots, cap * sizeof(u32));
+    ASSERT(s_QueueKeys && s_QueueSlots)
+    for (u32 i = s_QueueKeysCap; i < cap; i++) {
+      s_QueueKeys[i] = RENDER_QUEUE_NONE;
+    }
+    s_QueueKeysCap = cap;
+  }
+  for (u32 i = 0; i < count; i++) {
+    const u32 id = ids ? ids[i] : i;
+    s_QueueKeys[id] = InstanceKey(&s_Instances.m_data[id]);
+  }
+  // ids are ascending, and the sort is stable; new ties keep the order instances were added in
+  RenderQueue__Retain(&s_Queue, s_QueueKeys);
+  for (u32 i = 0; i < count; i++) {
+    const u32 id = ids ? ids[i] : i;
+    if (RENDER_QUEUE_NONE != s_QueueKeys[id]) {
+      RenderQueue__Push(&s_Queue, s_QueueKeys[id], id);
+      s_QueueKeys[id] = RENDER_QUEUE_NONE;
+    }
+  }
+  RenderQueue__Sort(&s_Queue);
+
+  for (u32 i = 0; i < count; i++) {
+    const u32 id = s_Queue.m_ids[i];
+    s_Visible[i] = s_Instances.m_gpu[id];
+    s_QueueSlots[id] = i;
+  }
+  s_VisibleCount = count;
+}
+
+/**
+ * Re-key the queued instance id, move it to its new slot, and repack the slots it moved over.
+ * Returns the span of slots repacked, and whether a draw boundary may have moved.
+ */
+static bool QueueMove(u32 id, Instances__Range_t* span) {
+  const u32 from = s_QueueSlots[id];
+  const u64 old = s_Queue.m_keys[from];
+  const u64 key = InstanceKey(&s_Instances.m_data[id]);
+  const u32 to = key == old ? from : RenderQueue__Rekey(&s_Queue, from, key);
+  span->first = MATH_MIN(from, to);
+  span->count = MATH_MAX(from, to) - span->first + 1;
+  if (to < from) {
+    memmove(&s_Visible[to + 1], &s_Visible[to], (from - to) * sizeof(InstanceGpu_t));
+  } else if (to > from) {
+    memmove(&s_Visible[from], &s_Visible[from + 1], (to - from) * sizeof(InstanceGpu_t));
+  }
+  s_Visible[to] = s_Instances.m_gpu[id];
+  for (u32 i = span->first; i < span->first + span->count; i++) {
+    s_QueueSlots[s_Queue.m_ids[i]] = i;
+  }
+  // moving within a run of one state leaves the runs as they were
+  return 0 != ((key ^ old) & (RENDER_QUEUE_LAYER_MASK | RENDER_QUEUE_PIPELINE_MASK));
+}
+
+/**
+ * Upload all of the packed instances. Returns the bytes uploaded.
+ */
+static u64 QueueUploadAll() {
+  // the buffer only holds the packed set; the carry-over copy on growth is wasted, but harmless
+  Vulkan__GrowVertexBuffer(&s_Vulkan, 1, sizeof(InstanceGpu_t) * s_VisibleCap);
+  if (s_VisibleCount > 0) {
+    Vulkan__UpdateVertexBuffer(&s_Vulkan, 1, sizeof(InstanceGpu_t) * s_VisibleCount, s_Visible);
+  }
+  return sizeof(InstanceGpu_t) * s_VisibleCount;
+}
+
+/**
+ * Draw the packed instances as the fewest draws their keys allow.
+ */
+static void QueueDraw() {
+  Vulkan__SetInstanceCount(&s_Vulkan, s_VisibleCount);
+  // textures are bindless, so only a pipeline change needs a new draw
+  const u32 drawsCount = RenderQueue__Merge(&s_Queue, RENDER_QUEUE_PIPELINE_MASK);
+  Vulkan__DrawBatch_t batches[MATH_MAX(drawsCount, 1)];
+  for (u32 i = 0; i < drawsCount; i++) {
+    batches[i].firstInstance = s_Queue.m_draws[i].firstInstance;
+    batches[i].instanceCount = s_Queue.m_draws[i].instanceCount;
+    batches[i].pipeline =
+        (Vulkan__Pipeline_t)(s_Queue.m_draws[i].state >> RENDER_QUEUE_PIPELINE_SHIFT);
+  }
+  Vulkan__SetDrawBatches(&s_Vulkan, drawsCount, batches);
+}
+
+/**
+ * Queue every instance, and upload what changed. Once instances are added, it all is queued and
+ * uploaded again; otherwise only the dirty instances are moved, and the spans they moved over
+ * uploaded. Returns the bytes uploaded.
+ */
+static u64 QueueUpload() {
+  if (0 == s_Instances.m_dirtyCount) {
+    return 0;
+  }
+  if (s_VisibleCount < s_Instances.m_count) {
+    Instances__ClearDirty(&s_Instances);
+    QueuePack(NULL, s_Instances.m_count);
+    const u64 bytes = QueueUploadAll();
+    QueueDraw();
+    return bytes;
+  }
+
+  Instances__Range_t spans[INSTANCES_DIRTY_RANGES_CAP];
+  u32 spansCount = 0;
+  bool redraw = false;
+  for (u32 r = 0; r < s_Instances.m_dirtyCount; r++) {
+    const Instances__Range_t range = s_Instances.m_dirty[r];
+    for (u32 id = range.first; id < range.first + range.count; id++) {
+      Instances__Range_t span;
+      redraw = QueueMove(id, &span) || redraw;
+      Instances__AddRange(spans, &spansCount, span.first, span.count);
+    }
+  }
+  Instances__ClearDirty(&s_Instances);
+
+  VkBufferCopy regions[INSTANCES_DIRTY_RANGES_CAP];
+  u64 bytes = 0;
+  for (u32 i = 0; i < spansCount; i++) {
+    regions[i].srcOffset = spans[i].first * sizeof(InstanceGpu_t);
+    regions[i].dstOffset = regions[i].srcOffset;
+    regions[i].size = spans[i].count * sizeof(InstanceGpu_t);
+    bytes += regions[i].size;
+  }
+  Vulkan__UpdateVertexBufferRegions(&s_Vulkan, 1, s_Visible, spansCount, regions);
+  if (redraw) {
+    QueueDraw();
+  }
+  return bytes;
+}
+
+/**
+ * Queue the instances in view, and upload them whenever the view or any instance changed.
+ * Returns the bytes uploaded.
+ */
+static u64 CullUpload() {
+  // the rectangle the camera sees on the z=0 plane
+  const f32 halfHeight = world.cam[2] * tanf(glm_rad(45.0f) / 2);
+  const f32 halfWidth = halfHeight * world.aspect;
+  vec4 rect = {
+      world.cam[0] - halfWidth,
+      world.cam[1] - halfHeight,
+      world.cam[0] + halfWidth,
+      world.cam[1] + halfHeight,
+  };
+  if (0 == s_Instances.m_dirtyCount && glm_vec4_eqv(rect, s_VisibleRect)) {
+    return 0;
+  }
+  glm_vec4_copy(rect, s_VisibleRect);
+  Instances__ClearDirty(&s_Instances);
+
+  const u32* ids;
+  const u32 count = Grid__Query(&s_Grid, rect[0], rect[1], rect[2], rect[3], &ids);
+  QueuePack(ids, count);
+  const u64 bytes = QueueUploadAll();
+  QueueDraw();
+  return bytes;
+}
+
+static void BenchRecord(u32 batchesCount) {
+  if (batchesCount > VULKAN_DRAW_BATCHES_CAP) {
+    LOG_INFOF(
+        "bench: %u batches is more than a frame holds; recording %u instead",
+        batchesCount,
+        VULKAN_DRAW_BATCHES_CAP)
+    batchesCount = VULKAN_DRAW_BATCHES_CAP;
+  }
+  // one instance per batch; recorded only, never submitted
+  Vulkan__DrawBatch_t* batches = malloc(batchesCount * sizeof(Vulkan__DrawBatch_t));
+  ASSERT(batches)
+  for (u32 i = 0; i < batchesCount; i++) {
+    batches[i].firstInstance = i;
+    batches[i].instanceCount = 1;
+    batches[i].pipeline = VULKAN_PIPELINE_OPAQUE;
+  }
+  Vulkan__SetDrawBatches(&s_Vulkan, batchesCount, batches);
+  free(batches);
+
+  f64 baseMs = 0;
+  u32 jobs = 1;
+  while (true) {
+    const u64 start = Now();
+    for (u32 r = 0; r < BENCH_RECORD_REPEATS; r++) {
+      Vulkan__RecordDrawSecondaries(&s_Vulkan, 0, jobs);
+    }
+    const f64 ms = (f64)(Now() - start) / CYCLES_PER_MILLISECOND / BENCH_RECORD_REPEATS;
+    if (1 == jobs) {
+      baseMs = ms;
+    }
+    LOG_INFOF(
+        "bench: recorded %u batches on %u threads in %.3f ms, speedup %.2fx",
+        batchesCount,
+        jobs,
+        ms,
+        baseMs / ms)
+    if (jobs == s_Jobs.m_threadsCount) {
+      break;
+    }
+    jobs = MATH_MIN(jobs * 2, s_Jobs.m_threadsCount);
+  }
+}
+
+/**
+ * Average ms to load a texture, then copy its pixels out as the staging upload would.
+ * Mapped cache pages only load when touched, so the copy is part of the cost.
+ */
+static f64 BenchLoadTexture(const char* file, bool useCache, bool cold, u8* scratch) {
+  char cacheFile[FILE_PATH_CAP];
+  Loader__CacheFile(file, cacheFile, sizeof(cacheFile));
+  u64 cycles = 0;
+  for (u32 r = 0; r < BENCH_TEXTURE_REPEATS; r++) {
+    if (cold) {
+      File__Evict(file);
+      File__Evict(cacheFile);
+    }
+    Loader__Image_t image;
+    image.file = file;
+    const u64 start = Now();
+    ASSERT_CONTEXT(Loader__Load(&image, useCache), "Failed to load texture. file: %s", file)
+    u64 size = 0;
+    for (u32 level = 0; level < image.mipsCount; level++) {
+      size += (u64)MATH_MAX(image.width >> level, 1) * MATH_MAX(image.height >> level, 1) * 4;
+    }
+    memcpy(scratch, image.pixels, size);
+    cycles += Now() - start;
+    Loader__Free(&image);
+  }
+  return (f64)cycles / CYCLES_PER_MILLISECOND / BENCH_TEXTURE_REPEATS;
+}
+
+static void BakeMeshes() {
+  // each atlas file describes the texture at the same index
+  for (u32 i = 0; i < ARRAY_COUNT(atlasFiles); i++) {
+    Loader__Image_t image;
+    image.file = textureFiles[i];
+    ASSERT_CONTEXT(Loader__Load(&image, false), "Failed to load texture. file: %s", image.file)
+    ASSERT_CONTEXT(
+        Atlas__BakeMeshes(atlasFiles[i], image.pixels, image.width, image.height),
+        "Failed to write atlas. file: %s",
+        atlasFiles[i])
+    Loader__Free(&image);
+  }
+}
+
+static void BenchTextures() {
+  for (u32 i = 0; i < ARRAY_COUNT(textureFiles); i++) {
+    // also (re)writes the cache, so the runs below find it valid
+    Loader__Image_t image;
+    image.file = textureFiles[i];
+    ASSERT_CONTEXT(Loader__Load(&image, true), "Failed to load texture. file: %s", textureFiles[i])
+    const u32 width = image.width;
+    const u32 height = image.height;
+    Loader__Free(&image);
+    // every level is at most half the one before, so the whole chain is under twice level 0
+    u8* scratch = malloc((u64)width * height * 4 * 2);
+    ASSERT(scratch)
+
+    const f64 pngCold = BenchLoadTexture(textureFiles[i], false, true, scratch);
+    const f64 pngWarm = BenchLoadTexture(textureFiles[i], false, false, scratch);
+    const f64 cacheCold = BenchLoadTexture(textureFiles[i], true, true, scratch);
+    const f64 cacheWarm = BenchLoadTexture(textureFiles[i], true, false, scratch);
+    LOG_INFOF(
+        "bench: %s %ux%u, png cold %.3f ms warm %.3f ms, cache cold %.3f ms warm %.3f ms",
+        textureFiles[i],
+        width,
+        height,
+        pngCold,
+        pngWarm,
+        cacheCold,
+        cacheWarm)
+    free(scratch);
+  }
+}
+
+/**
+ * Average ms to sort and merge the render keys of count random sprites.
+ */
+static void BenchQueueSize(RenderQueue_t* queue, u32 count) {
+  // a few layers, pipelines and textures; depth varies per sprite
+  u64* keys = malloc(count * sizeof(u64));
+  ASSERT(keys)
+  for (u32 i = 0; i < count; i++) {
+    keys[i] = RenderQueue__Key(
+        (u32)rand() % 3,
+        (u32)rand() % 2,
+        (f32)rand() / RAND_MAX,
+        (u32)rand() % 4);
+  }
+
+  u64 sortCycles = 0;
+  u64 mergeCycles = 0;
+  u32 drawsCount = 0;
+  for (u32 r = 0; r < BENCH_QUEUE_REPEATS; r++) {
+    RenderQueue__Clear(queue);
+    for (u32 i = 0; i < count; i++) {
+      RenderQueue__Push(queue, keys[i], i);
+    }
+
+    u64 start = Now();
+    RenderQueue__Sort(queue);
+    sortCycles += Now() - start;
+
+    start = Now();
+    drawsCount = RenderQueue__Merge(queue, RENDER_QUEUE_PIPELINE_MASK);
+    mergeCycles += Now() - start;
+  }
+  free(keys);
+
+  const f64 sortMs = (f64)sortCycles / CYCLES_PER_MILLISECOND / BENCH_QUEUE_REPEATS;
+  const f64 mergeMs = (f64)mergeCycles / CYCLES_PER_MILLISECOND / BENCH_QUEUE_REPEATS;
+  LOG_INFOF(
+      "bench: queue %u sprites, sort %.3f ms (%.1f M/s), merge %.3f ms (%.1f M/s) into %u draws",
+      count,
+      sortMs,
+      count / sortMs / 1000,
+      mergeMs,
+      count / mergeMs / 1000,
+      drawsCount)
+}
+
+/**
+ * Average ms to y-sort count sprites again a frame after the last: 1% of them moved a little,
+ * and the view panned so 0.5% left it and as many came in. Includes making their keys.
+ */
+static void BenchQueueCoherent(RenderQueue_t* queue, u32 count) {
+  // sprites come into view from the pool past the first count, in order
+  const u32 step = MATH_MAX(count / 200, 1);
+  const u32 moved = count / 100;
+  const u32 poolCount = count + step * BENCH_QUEUE_REPEATS;
+  f32* feetY = malloc(poolCount * sizeof(f32));
+  u64* keysById = malloc(poolCount * sizeof(u64));
+  ASSERT(feetY && keysById)
+  for (u32 i = 0; i < poolCount; i++) {
+    feetY[i] = (f32)rand() / RAND_MAX;
+    keysById[i] = RENDER_QUEUE_NONE;
+  }
+
+  // the first frame sorts from scratch
+  RenderQueue__Clear(queue);
+  for (u32 i = 0; i < count; i++) {
+    RenderQueue__Push(queue, RenderQueue__Key(0, 0, feetY[i], 0), i);
+  }
+  RenderQueue__Sort(queue);
+
+  u64 cycles = 0;
+  for (u32 r = 0; r < BENCH_QUEUE_REPEATS; r++) {
+    const u32 first = (r + 1) * step;
+    for (u32 i = 0; i < moved; i++) {
+      feetY[first + (u32)rand() % count] += ((f32)rand() / RAND_MAX - 0.5f) / 1000;
+    }
+
+    const u64 start = Now();
+    for (u32 i = first; i < first + count; i++) {
+      keysById[i] = RenderQueue__Key(0, 0, feetY[i], 0);
+    }
+    RenderQueue__Retain(queue, keysById);
+    for (u32 i = first; i < first + count; i++) {
+      if (RENDER_QUEUE_NONE != keysById[i]) {
+        RenderQueue__Push(queue, keysById[i], i);
+        keysById[i] = RENDER_QUEUE_NONE;
+      }
+    }
+    RenderQueue__Sort(queue);
+    cycles += Now() - start;
+  }
+  free(feetY);
+  free(keysById);
+
+  LOG_INFOF(
+      "bench: queue %u sprites, coherent y-sort %.3f ms per frame, %u moved, %u entered",
+      count,
+      (f64)cycles / CYCLES_PER_MILLISECOND / BENCH_QUEUE_REPEATS,
+      moved,
+      step)
+}
+
+static void BenchQueue() {
+  RenderQueue_t queue;
+  RenderQueue__New(&queue);
+  BenchQueueSize(&queue, 100000);
+  BenchQueueSize(&queue, 1000000);
+  BenchQueueCoherent(&queue, 100000);
+  BenchQueueCoherent(&queue, 1000000);
+  RenderQueue__Shutdown(&queue);
+}